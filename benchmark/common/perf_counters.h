@@ -0,0 +1,142 @@
+#pragma once
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <benchmark/benchmark.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Hardware and scheduler counters for a benchmark, read with perf_event_open and reported as
+// <name>_per_item user counters. Off unless BENCH_PERF_COUNTERS is set to something other than
+// "0"; then every counter the kernel refuses (no PMU in a VM, perf_event_paranoid, seccomp) is
+// left out, and the reasons are printed once per process.
+//
+// Counters follow the calling thread and, through inherit, every thread it creates afterwards,
+// so construct this before starting workers. Only the time between start() and stop() counts.
+class perf_counters {
+   public:
+    perf_counters() {
+        if (!requested()) {
+            return;
+        }
+        for (const event_spec& spec : specs()) {
+            int fd = open_event(spec, false);
+            if (fd < 0 && errno == EACCES && spec.user_only_ok) {
+                fd = open_event(spec, true);
+            }
+            if (fd < 0) {
+                note_unavailable(spec.name, errno);
+                continue;
+            }
+            counters_.push_back({spec.name, fd});
+        }
+    }
+    ~perf_counters() {
+        for (const counter& c : counters_) {
+            ::close(c.fd);
+        }
+    }
+    perf_counters(const perf_counters&) = delete;
+    perf_counters& operator=(const perf_counters&) = delete;
+
+    static bool requested() {
+        const char* env = std::getenv("BENCH_PERF_COUNTERS");
+        return env && *env && std::strcmp(env, "0") != 0;
+    }
+
+    void start() {
+        for (const counter& c : counters_) {
+            ::ioctl(c.fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+    void stop() {
+        for (const counter& c : counters_) {
+            ::ioctl(c.fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+
+    // Counts are scaled up when the kernel multiplexed a counter; one that never got scheduled
+    // is left out rather than reported as 0.
+    void report(benchmark::State& state, double items) const {
+        if (items <= 0) {
+            return;
+        }
+        for (const counter& c : counters_) {
+            uint64_t values[3] = {0, 0, 0};
+            if (::read(c.fd, values, sizeof(values)) != static_cast<ssize_t>(sizeof(values)) || values[2] == 0) {
+                continue;
+            }
+            double count = static_cast<double>(values[0]) * static_cast<double>(values[1]) /
+                           static_cast<double>(values[2]);
+            state.counters[std::string(c.name) + "_per_item"] = count / items;
+        }
+    }
+
+   private:
+    struct event_spec {
+        const char* name;
+        uint32_t type;
+        uint64_t config;
+        // Whether counting only user space is still meaningful, i.e. worth a retry when the
+        // kernel refuses to count kernel space too. Context switches happen in the kernel.
+        bool user_only_ok;
+    };
+
+    struct counter {
+        const char* name;
+        int fd;
+    };
+
+    static constexpr uint64_t cache_event(uint64_t cache) {
+        return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    }
+
+    static const std::vector<event_spec>& specs() {
+        static const std::vector<event_spec> events = {
+            {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, true},
+            {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, true},
+            {"l1d_misses", PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_L1D), true},
+            {"llc_misses", PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_LL), true},
+            {"branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, true},
+            {"ctx_switches", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, false},
+        };
+        return events;
+    }
+
+    static int open_event(const event_spec& spec, bool user_only) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = spec.type;
+        attr.config = spec.config;
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = user_only ? 1 : 0;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+    }
+
+    static void note_unavailable(const char* name, int error) {
+        static std::vector<std::string> noted;
+        for (const std::string& n : noted) {
+            if (n == name) {
+                return;
+            }
+        }
+        noted.push_back(name);
+        std::fprintf(stderr, "perf_counters: %s unavailable (%s), not reported\n", name, std::strerror(error));
+    }
+
+   private:
+    std::vector<counter> counters_;
+};
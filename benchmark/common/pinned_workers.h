@@ -0,0 +1,170 @@
+#pragma once
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "opt/back_off.h"
+#include "opt/cache_line.h"
+
+// Barrier for a fixed number of threads that can be passed any number of times. Waiters spin
+// with back_off, so a release costs no syscall and no scheduler wakeup.
+class spin_barrier {
+   public:
+    explicit spin_barrier(size_t count) : count_(count) {}
+    spin_barrier(const spin_barrier&) = delete;
+    spin_barrier& operator=(const spin_barrier&) = delete;
+
+    void arrive_and_wait() {
+        size_t generation = generation_.load(std::memory_order_acquire);
+        if (waiting_.fetch_add(1, std::memory_order_acq_rel) + 1 == count_) {
+            waiting_.store(0, std::memory_order_relaxed);
+            generation_.fetch_add(1, std::memory_order_release);
+            return;
+        }
+        back_off<> wait;
+        while (generation_.load(std::memory_order_acquire) == generation) {
+            wait();
+        }
+    }
+
+   private:
+    const size_t count_;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> waiting_{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> generation_{0};
+};
+
+// Start and finish of one worker in a phase, in steady_clock nanoseconds.
+struct worker_times {
+    alignas(CACHE_LINE_SIZE) uint64_t start_ns{0};
+    uint64_t finish_ns{0};
+};
+
+struct phase_times {
+    std::vector<worker_times> workers;
+
+    // From the first worker starting to the last of workers [first, last) finishing.
+    uint64_t elapsed_ns(size_t first, size_t last) const {
+        uint64_t start = UINT64_MAX;
+        uint64_t finish = 0;
+        for (const worker_times& times : workers) {
+            start = times.start_ns < start ? times.start_ns : start;
+        }
+        for (size_t i = first; i < last && i < workers.size(); i++) {
+            finish = workers[i].finish_ns > finish ? workers[i].finish_ns : finish;
+        }
+        return finish > start ? finish - start : 0;
+    }
+    uint64_t elapsed_ns() const {
+        return elapsed_ns(0, workers.size());
+    }
+    // How far apart the workers were released.
+    uint64_t start_skew_ns() const {
+        uint64_t first = UINT64_MAX;
+        uint64_t last = 0;
+        for (const worker_times& times : workers) {
+            first = times.start_ns < first ? times.start_ns : first;
+            last = times.start_ns > last ? times.start_ns : last;
+        }
+        return last > first ? last - first : 0;
+    }
+};
+
+// Worker threads created once per benchmark and pinned round-robin to the CPUs this process
+// may run on. run() releases all of them into a phase through a spin barrier and returns when
+// the last one is done, so thread creation and condvar wakeups stay out of the measurement.
+class pinned_worker_pool {
+   public:
+    explicit pinned_worker_pool(size_t worker_num)
+        : start_(worker_num + 1), done_(worker_num + 1), times_{std::vector<worker_times>(worker_num)} {
+        std::vector<int> cpus = allowed_cpus();
+        for (size_t i = 0; i < worker_num; i++) {
+            threads_.emplace_back(&pinned_worker_pool::worker_main, this, i);
+            if (!cpus.empty()) {
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                CPU_SET(cpus[i % cpus.size()], &set);
+                pinned_ = pthread_setaffinity_np(threads_.back().native_handle(), sizeof(set), &set) == 0 && pinned_;
+            } else {
+                pinned_ = false;
+            }
+        }
+    }
+    ~pinned_worker_pool() {
+        stop_.store(true, std::memory_order_relaxed);
+        start_.arrive_and_wait();
+        for (std::thread& thread : threads_) {
+            thread.join();
+        }
+    }
+    pinned_worker_pool(const pinned_worker_pool&) = delete;
+    pinned_worker_pool& operator=(const pinned_worker_pool&) = delete;
+
+    size_t size() const {
+        return threads_.size();
+    }
+    // False if some worker could not be pinned; it then runs wherever the scheduler puts it.
+    bool pinned() const {
+        return pinned_;
+    }
+
+    // Runs task(worker_index) on every worker. The result stays valid until the next run().
+    const phase_times& run(const std::function<void(size_t)>& task) {
+        task_ = &task;
+        start_.arrive_and_wait();
+        done_.arrive_and_wait();
+        return times_;
+    }
+
+   private:
+    static uint64_t now_ns() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                         std::chrono::steady_clock::now().time_since_epoch())
+                                         .count());
+    }
+
+    static std::vector<int> allowed_cpus() {
+        std::vector<int> cpus;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+            return cpus;
+        }
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+        return cpus;
+    }
+
+    void worker_main(size_t index) {
+        while (true) {
+            start_.arrive_and_wait();
+            if (stop_.load(std::memory_order_relaxed)) {
+                return;
+            }
+            worker_times& times = times_.workers[index];
+            times.start_ns = now_ns();
+            (*task_)(index);
+            times.finish_ns = now_ns();
+            done_.arrive_and_wait();
+        }
+    }
+
+   private:
+    spin_barrier start_;
+    spin_barrier done_;
+    const std::function<void(size_t)>* task_{nullptr};
+    std::atomic<bool> stop_{false};
+    bool pinned_{true};
+    phase_times times_;
+    std::vector<std::thread> threads_;
+};
@@ -0,0 +1,196 @@
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "fsm/dense_table.h"
+#include "fsm/fsm.h"
+#include "fsm/fsm_fleet.h"
+#include "pinned_workers.h"
+
+// Enums without enumerators, so one pair of types serves every machine size.
+enum class bench_state : uint32_t {};
+enum class bench_event : uint32_t {};
+
+constexpr size_t EVENT_BATCH = 1024;
+constexpr size_t FLEET_SIZE = 4096;
+
+// N states and N events, all with entry, exit and callback actions. Even events move state s
+// to (s + e + 1) % N, odd events have no transition, so one machine serves both kinds of stream.
+struct bench_tables {
+    StateTable<bench_state, bench_event> states;
+    StateChangeTable<bench_state, bench_event> changes;
+    uint64_t actions{0};
+
+    explicit bench_tables(size_t n) {
+        Action<bench_event> count = [this](bench_event) { actions++; };
+        for (size_t s = 0; s < n; s++) {
+            states[static_cast<bench_state>(s)] = {count, count, count};
+            for (size_t e = 0; e < n; e += 2) {
+                changes[static_cast<bench_state>(s)][static_cast<bench_event>(e)] =
+                    static_cast<bench_state>((s + e + 1) % n);
+            }
+        }
+    }
+};
+
+// A fixed pseudo-random stream of only even (transition) or only odd (no transition) events.
+inline std::vector<bench_event> make_events(size_t n, bool transitions, size_t count) {
+    std::vector<bench_event> events;
+    events.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        size_t e = (i * 7 * 2 + (transitions ? 0 : 1)) % n;
+        events.push_back(static_cast<bench_event>(e));
+    }
+    return events;
+}
+
+template <size_t N>
+using map_dispatcher = FsmDispatcher<bench_state, bench_event>;
+
+template <size_t N>
+using dense_dispatcher = FsmDispatcher<bench_state, bench_event, FsmDenseStateTable<bench_state, bench_event, N>,
+                                       FsmDenseChangeTable<bench_state, bench_event, N, N>>;
+
+template <size_t N, template <size_t> class Dispatcher>
+using bench_fsm = FSM<bench_state, bench_event, Dispatcher<N>>;
+
+// One submitter: EVENT_BATCH - 1 posts, then a Submit whose future tells the mailbox is drained.
+// range(0): 1 = events with transitions, 0 = without.
+template <size_t N, template <size_t> class Dispatcher>
+void bm_fsm_throughput(benchmark::State& state) {
+    bench_tables tables(N);
+    std::vector<bench_event> events = make_events(N, state.range(0) != 0, EVENT_BATCH);
+    bench_fsm<N, Dispatcher> fsm(&tables.states, &tables.changes, bench_state{});
+
+    for (auto _ : state) {
+        for (size_t i = 0; i + 1 < events.size(); i++) {
+            fsm.Post(events[i]);
+        }
+        fsm.Submit(events.back()).wait();
+    }
+
+    state.SetItemsProcessed(state.iterations() * events.size());
+}
+
+// Round trip of a single Submit: enqueue, processor wakeup, dispatch, promise.
+template <size_t N, template <size_t> class Dispatcher>
+void bm_fsm_submit_latency(benchmark::State& state) {
+    bench_tables tables(N);
+    std::vector<bench_event> events = make_events(N, state.range(0) != 0, EVENT_BATCH);
+    bench_fsm<N, Dispatcher> fsm(&tables.states, &tables.changes, bench_state{});
+    size_t i = 0;
+
+    for (auto _ : state) {
+        fsm.Submit(events[i++ % events.size()]).wait();
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+// range(1) pinned submitters post EVENT_BATCH events between them into one FSM.
+template <size_t N, template <size_t> class Dispatcher>
+void bm_fsm_many_submitters(benchmark::State& state) {
+    bench_tables tables(N);
+    std::vector<bench_event> events = make_events(N, state.range(0) != 0, EVENT_BATCH);
+    bench_fsm<N, Dispatcher> fsm(&tables.states, &tables.changes, bench_state{});
+    size_t submitter_num = state.range(1);
+    pinned_worker_pool submitters(submitter_num);
+    std::function<void(size_t)> task = [&](size_t submitter) {
+        for (size_t i = submitter; i < events.size(); i += submitter_num) {
+            fsm.Post(events[i]);
+        }
+    };
+
+    for (auto _ : state) {
+        submitters.run(task);
+        fsm.Submit(events.front()).wait();
+    }
+
+    state.SetItemsProcessed(state.iterations() * (events.size() + 1));
+}
+
+// The dispatch cost alone: FsmInline on the calling thread, no mailbox or promise.
+template <size_t N, template <size_t> class Dispatcher>
+void bm_fsm_inline(benchmark::State& state) {
+    bench_tables tables(N);
+    std::vector<bench_event> events = make_events(N, state.range(0) != 0, EVENT_BATCH);
+    FsmInline<bench_state, bench_event, Dispatcher<N>> fsm(&tables.states, &tables.changes, bench_state{});
+
+    for (auto _ : state) {
+        for (bench_event event : events) {
+            fsm.Dispatch(event);
+        }
+        benchmark::DoNotOptimize(fsm.GetState());
+    }
+
+    state.SetItemsProcessed(state.iterations() * events.size());
+}
+
+// Batch dispatch over FLEET_SIZE machines without actions, EVENT_BATCH events per batch.
+template <size_t N>
+void bm_fleet_dispatch(benchmark::State& state) {
+    bench_tables tables(N);
+    std::vector<bench_event> events = make_events(N, state.range(0) != 0, EVENT_BATCH);
+    std::vector<uint32_t> ids(events.size());
+    for (size_t i = 0; i < ids.size(); i++) {
+        ids[i] = static_cast<uint32_t>((i * 2654435761u) % FLEET_SIZE);
+    }
+    FsmFleet<bench_state, bench_event, N, N> fleet(nullptr, &tables.changes, FLEET_SIZE, bench_state{});
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(fleet.Dispatch(ids.data(), events.data(), events.size()));
+    }
+
+    state.SetItemsProcessed(state.iterations() * events.size());
+}
+
+static void transition_kinds(benchmark::internal::Benchmark* bench) {
+    bench->ArgName("transitions")->Arg(1)->Arg(0);
+}
+
+static void submitter_counts(benchmark::internal::Benchmark* bench) {
+    bench->ArgNames({"transitions", "submitters"});
+    for (int64_t submitters : {1, 2, 4, 8}) {
+        bench->Args({1, submitters});
+    }
+}
+
+// ============================================================================
+// Single Submitter Throughput
+// ============================================================================
+BENCHMARK_TEMPLATE(bm_fsm_throughput, 4, map_dispatcher)->Apply(transition_kinds)->UseRealTime();
+BENCHMARK_TEMPLATE(bm_fsm_throughput, 16, map_dispatcher)->Apply(transition_kinds)->UseRealTime();
+BENCHMARK_TEMPLATE(bm_fsm_throughput, 64, map_dispatcher)->Apply(transition_kinds)->UseRealTime();
+BENCHMARK_TEMPLATE(bm_fsm_throughput, 4, dense_dispatcher)->Apply(transition_kinds)->UseRealTime();
+BENCHMARK_TEMPLATE(bm_fsm_throughput, 16, dense_dispatcher)->Apply(transition_kinds)->UseRealTime();
+BENCHMARK_TEMPLATE(bm_fsm_throughput, 64, dense_dispatcher)->Apply(transition_kinds)->UseRealTime();
+
+// ============================================================================
+// Submit Round Trip Latency
+// ============================================================================
+BENCHMARK_TEMPLATE(bm_fsm_submit_latency, 4, map_dispatcher)->Apply(transition_kinds)->UseRealTime();
+BENCHMARK_TEMPLATE(bm_fsm_submit_latency, 64, map_dispatcher)->Apply(transition_kinds)->UseRealTime();
+BENCHMARK_TEMPLATE(bm_fsm_submit_latency, 4, dense_dispatcher)->Apply(transition_kinds)->UseRealTime();
+BENCHMARK_TEMPLATE(bm_fsm_submit_latency, 64, dense_dispatcher)->Apply(transition_kinds)->UseRealTime();
+
+// ============================================================================
+// Many Submitters
+// ============================================================================
+BENCHMARK_TEMPLATE(bm_fsm_many_submitters, 16, map_dispatcher)->Apply(submitter_counts)->UseRealTime();
+BENCHMARK_TEMPLATE(bm_fsm_many_submitters, 16, dense_dispatcher)->Apply(submitter_counts)->UseRealTime();
+
+// ============================================================================
+// Dispatch Only - map vs dense tables, FsmInline and FsmFleet
+// ============================================================================
+BENCHMARK_TEMPLATE(bm_fsm_inline, 4, map_dispatcher)->Apply(transition_kinds);
+BENCHMARK_TEMPLATE(bm_fsm_inline, 16, map_dispatcher)->Apply(transition_kinds);
+BENCHMARK_TEMPLATE(bm_fsm_inline, 64, map_dispatcher)->Apply(transition_kinds);
+BENCHMARK_TEMPLATE(bm_fsm_inline, 4, dense_dispatcher)->Apply(transition_kinds);
+BENCHMARK_TEMPLATE(bm_fsm_inline, 16, dense_dispatcher)->Apply(transition_kinds);
+BENCHMARK_TEMPLATE(bm_fsm_inline, 64, dense_dispatcher)->Apply(transition_kinds);
+BENCHMARK_TEMPLATE(bm_fleet_dispatch, 4)->Apply(transition_kinds);
+BENCHMARK_TEMPLATE(bm_fleet_dispatch, 16)->Apply(transition_kinds);
+BENCHMARK_TEMPLATE(bm_fleet_dispatch, 64)->Apply(transition_kinds);
@@ -0,0 +1,212 @@
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "hp/hp.h"
+
+using hp = detail::hp::hp;
+using detail::hp::retired_ptr;
+using detail::hp::scan_type;
+using detail::hp::thread_data;
+
+struct bench_node {
+    uint64_t value{0};
+};
+
+// Retired nodes live in vectors owned by the benchmark, so disposal is free and only the SMR
+// bookkeeping is measured.
+static void dispose_nothing(void*) {}
+
+static void protect_all(thread_data* td, bench_node* nodes) {
+    for (size_t i = 0; i < td->hazards.capacity(); i++) {
+        td->hazards[i].set(&nodes[i]);
+    }
+}
+
+// One SMR instance per benchmark run, with the benchmark thread attached. construct() is a no-op
+// while an instance exists, so every run tears its instance down again.
+class hp_domain {
+   public:
+    hp_domain(size_t hazard_num, size_t retired_num, scan_type type) {
+        hp::construct(hazard_num, detail::hp::smr::kDefaultMaxThreadCount, retired_num, type);
+        hp::attach_thread();
+    }
+    ~hp_domain() {
+        hp::detach_thread();
+        hp::destruct();
+    }
+    hp_domain(const hp_domain&) = delete;
+    hp_domain& operator=(const hp_domain&) = delete;
+};
+
+// thread_num threads attached to the SMR with every hazard slot set to a live node, i.e. the
+// hazard set a scan has to check. Slots [0, hazard_num) of live are left to the benchmark thread.
+// The holders block on a future rather than spin, so they take no CPU from the scanning thread,
+// and detach before the domain is destroyed.
+class hazard_holders {
+   public:
+    hazard_holders(size_t thread_num, size_t hazard_num, std::vector<bench_node>& live) : attached_(thread_num) {
+        std::shared_future<void> released = release_.get_future().share();
+        for (size_t t = 0; t < thread_num; t++) {
+            threads_.emplace_back([this, released, t, nodes = &live[(t + 1) * hazard_num]]() {
+                hp::attach_thread();
+                protect_all(hp::tls_manager::get_tls(), nodes);
+                attached_[t].set_value();
+                released.wait();
+                hp::detach_thread();
+            });
+        }
+        for (std::promise<void>& promise : attached_) {
+            promise.get_future().wait();
+        }
+    }
+    ~hazard_holders() {
+        release_.set_value();
+        for (std::thread& thread : threads_) {
+            thread.join();
+        }
+    }
+    hazard_holders(const hazard_holders&) = delete;
+    hazard_holders& operator=(const hazard_holders&) = delete;
+
+   private:
+    std::vector<std::promise<void>> attached_;
+    std::promise<void> release_;
+    std::vector<std::thread> threads_;
+};
+
+static scan_type scan_arg(int64_t inplace) {
+    return inplace != 0 ? scan_type::inplace : scan_type::classic;
+}
+
+// ============================================================================
+// Guards
+// ============================================================================
+
+// Allocating and freeing one hazard slot of an attached thread.
+static void bm_hp_guard(benchmark::State& state) {
+    hp_domain domain(detail::hp::smr::kDefaultHazardPtrCount, detail::hp::smr::kDefaultMaxRetiredPtrCount,
+                     detail::hp::smr::kDefaultScanType);
+
+    for (auto _ : state) {
+        hp::guard guard;
+        benchmark::DoNotOptimize(guard.is_linked());
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+// protect() of a pointer nobody changes: one store and two loads in the common case.
+static void bm_hp_protect(benchmark::State& state) {
+    hp_domain domain(detail::hp::smr::kDefaultHazardPtrCount, detail::hp::smr::kDefaultMaxRetiredPtrCount,
+                     detail::hp::smr::kDefaultScanType);
+    bench_node node;
+    std::atomic<bench_node*> source{&node};
+    hp::guard guard;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(guard.protect(source));
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Allocating and freeing N hazard slots at once.
+template <size_t N>
+void bm_hp_scoped_guards(benchmark::State& state) {
+    size_t hazard_num = N > detail::hp::smr::kDefaultHazardPtrCount ? N : detail::hp::smr::kDefaultHazardPtrCount;
+    hp_domain domain(hazard_num, detail::hp::smr::kDefaultMaxRetiredPtrCount, detail::hp::smr::kDefaultScanType);
+
+    for (auto _ : state) {
+        hp::scoped_guards<N> guards;
+        benchmark::DoNotOptimize(&guards);
+    }
+
+    state.SetItemsProcessed(state.iterations() * N);
+}
+
+// ============================================================================
+// Retire and Scan
+// ============================================================================
+// Arguments: threads (including the benchmark thread), hazards per thread, retired array size,
+// and 1 for inplace_scan or 0 for classic_scan. All hazards of all threads are set to live nodes,
+// and no retired node is protected: the usual case, and the worst one for inplace_scan, which
+// walks every hazard for every retired pointer.
+
+// retire() of one node, including the scan every retired_num retires.
+static void bm_hp_retire(benchmark::State& state) {
+    size_t thread_num = state.range(0);
+    size_t hazard_num = state.range(1);
+    size_t retired_num = state.range(2);
+    hp_domain domain(hazard_num, retired_num, scan_arg(state.range(3)));
+    std::vector<bench_node> live(thread_num * hazard_num);
+    std::vector<bench_node> retired(retired_num);
+    protect_all(hp::tls_manager::get_tls(), &live[0]);
+    hazard_holders holders(thread_num - 1, hazard_num, live);
+    size_t i = 0;
+
+    for (auto _ : state) {
+        hp::retire(&retired[i], dispose_nothing);
+        i = i + 1 < retired.size() ? i + 1 : 0;
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+// One scan of a full retired array; filling the array is not timed.
+static void bm_hp_scan(benchmark::State& state) {
+    size_t thread_num = state.range(0);
+    size_t hazard_num = state.range(1);
+    size_t retired_num = state.range(2);
+    hp_domain domain(hazard_num, retired_num, scan_arg(state.range(3)));
+    std::vector<bench_node> live(thread_num * hazard_num);
+    std::vector<bench_node> retired(retired_num);
+    thread_data* td = hp::tls_manager::get_tls();
+    protect_all(td, &live[0]);
+    hazard_holders holders(thread_num - 1, hazard_num, live);
+
+    for (auto _ : state) {
+        for (size_t i = td->retired.size(); i < retired_num; i++) {
+            td->retired.push(retired_ptr(&retired[i], dispose_nothing));
+        }
+        auto start = std::chrono::steady_clock::now();
+        hp::scan();
+        auto end = std::chrono::steady_clock::now();
+        state.SetIterationTime(std::chrono::duration<double>(end - start).count());
+    }
+
+    state.SetItemsProcessed(state.iterations() * retired_num);
+}
+
+// Each sweep varies one parameter around the construct() defaults (8 hazards, 100 retired),
+// with 4 threads, for both scans.
+static void smr_sweeps(benchmark::internal::Benchmark* bench) {
+    bench->ArgNames({"threads", "hazards", "retired", "inplace"});
+    for (int64_t inplace : {0, 1}) {
+        for (int64_t threads : {1, 2, 4, 8, 16}) {
+            bench->Args({threads, 8, 100, inplace});
+        }
+        for (int64_t hazards : {2, 4, 16, 32}) {
+            bench->Args({4, hazards, 100, inplace});
+        }
+        for (int64_t retired : {25, 50, 200, 400, 1600}) {
+            bench->Args({4, 8, retired, inplace});
+        }
+    }
+}
+
+BENCHMARK(bm_hp_guard);
+BENCHMARK(bm_hp_protect);
+BENCHMARK_TEMPLATE(bm_hp_scoped_guards, 1);
+BENCHMARK_TEMPLATE(bm_hp_scoped_guards, 2);
+BENCHMARK_TEMPLATE(bm_hp_scoped_guards, 4);
+BENCHMARK_TEMPLATE(bm_hp_scoped_guards, 8);
+
+BENCHMARK(bm_hp_retire)->Apply(smr_sweeps);
+BENCHMARK(bm_hp_scan)->Apply(smr_sweeps)->UseManualTime();
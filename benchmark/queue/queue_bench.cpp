@@ -1,16 +1,23 @@
 #include <benchmark/benchmark.h>
 
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "fsm/fsm_handle_pool.h"
 #include "queue/faa_bounded_queue.h"
 #include "queue/ff_bounded_queue.h"
 #include "queue/lock_bounded_queue.h"
 #include "queue/lock_free_bounded_queue.h"
 #include "queue/lock_queue.h"
+#include "queue/mpsc_queue.h"
 #include "queue/ms_queue.h"
+#include "perf_counters.h"
+#include "pinned_workers.h"
 #include "queue_factory.h"
 #include "queue_helpers.h"
 #include "test_types.h"
-#include "thread_helpers.h"
-#include "thread_sync.h"
 
 constexpr size_t BULK_ITEM_COUNT = 1024 * 16;
 
@@ -20,12 +27,16 @@ void bm_single_thread_round_trip_int(benchmark::State& state) {
     int value = 42;
     int result;
 
+    perf_counters perf;
+    perf.start();
     for (auto _ : state) {
         q->enqueue(value);
         q->dequeue(result);
     }
+    perf.stop();
 
     state.SetItemsProcessed(state.iterations() * 2);
+    perf.report(state, static_cast<double>(state.iterations() * 2));
     state.SetBytesProcessed(state.iterations() * 2 * sizeof(int));
 }
 
@@ -35,12 +46,16 @@ void bm_round_trip_small_object(benchmark::State& state) {
     small_object value{42};
     small_object result;
 
+    perf_counters perf;
+    perf.start();
     for (auto _ : state) {
         q->enqueue(value);
         q->dequeue(result);
     }
+    perf.stop();
 
     state.SetItemsProcessed(state.iterations() * 2);
+    perf.report(state, static_cast<double>(state.iterations() * 2));
     state.SetBytesProcessed(state.iterations() * 2 * sizeof(small_object));
 }
 
@@ -50,12 +65,16 @@ void bm_round_trip_medium_object(benchmark::State& state) {
     medium_object value{42};
     medium_object result;
 
+    perf_counters perf;
+    perf.start();
     for (auto _ : state) {
         q->enqueue(value);
         q->dequeue(result);
     }
+    perf.stop();
 
     state.SetItemsProcessed(state.iterations() * 2);
+    perf.report(state, static_cast<double>(state.iterations() * 2));
     state.SetBytesProcessed(state.iterations() * 2 * sizeof(medium_object));
 }
 
@@ -65,12 +84,16 @@ void bm_round_trip_large_object(benchmark::State& state) {
     large_object value{42};
     large_object result;
 
+    perf_counters perf;
+    perf.start();
     for (auto _ : state) {
         q->enqueue(value);
         q->dequeue(result);
     }
+    perf.stop();
 
     state.SetItemsProcessed(state.iterations() * 2);
+    perf.report(state, static_cast<double>(state.iterations() * 2));
     state.SetBytesProcessed(state.iterations() * 2 * sizeof(large_object));
 }
 
@@ -80,36 +103,88 @@ void bm_capacity(benchmark::State& state) {
     int value = 42;
     int result;
 
+    perf_counters perf;
+    perf.start();
     for (auto _ : state) {
         q.enqueue(value);
         q.dequeue(result);
     }
+    perf.stop();
+
+    perf.report(state, static_cast<double>(state.iterations() * 2));
+}
+
+// Consumers poll until all items are taken. Counts are published in batches, and always before
+// polling an empty queue, so the shared counter is touched rarely and cannot miss any item.
+template <typename Queue>
+void consume_until(Queue& queue, std::atomic<size_t>& consumed, size_t total) {
+    constexpr size_t PUBLISH_BATCH = 64;
+    size_t local = 0;
+    while (consumed.load(std::memory_order_relaxed) < total) {
+        if (queue.try_dequeue_with([](typename Queue::value_type&) {})) {
+            if (++local == PUBLISH_BATCH) {
+                consumed.fetch_add(local, std::memory_order_relaxed);
+                local = 0;
+            }
+        } else if (local > 0) {
+            consumed.fetch_add(local, std::memory_order_relaxed);
+            local = 0;
+        } else {
+            std::this_thread::yield();
+        }
+    }
 }
 
+// Workers 0..producer_num-1 produce, the rest consume. Threads and queue live for the whole
+// benchmark and each iteration is timed from the first worker starting to the last finishing.
+// Counters: produce_ns until the last producer is done, drain_ns from then until the queue is
+// empty, start_skew_ns between the first and last worker being released.
 template <typename Queue>
 void run_producer_consumer_benchmark(benchmark::State& state,
                                      size_t producer_num,
                                      size_t consumer_num,
                                      size_t items_per_producer) {
+    using element_type = typename Queue::value_type;
+    auto q = queue_factory<Queue, QUEUE_CAPACITY>::create();
+    perf_counters perf;
+    pinned_worker_pool workers(producer_num + consumer_num);
+    const size_t total = producer_num * items_per_producer;
+    std::atomic<size_t> consumed{0};
+
+    std::function<void(size_t)> task = [&](size_t worker) {
+        if (worker < producer_num) {
+            for (size_t i = 0; i < items_per_producer; i++) {
+                q->enqueue(static_cast<element_type>(worker));
+            }
+        } else {
+            consume_until(*q, consumed, total);
+        }
+    };
+
+    double produce_ns = 0;
+    double drain_ns = 0;
+    double start_skew_ns = 0;
+    perf.start();
     for (auto _ : state) {
-        auto q = queue_factory<Queue, QUEUE_CAPACITY>::create();
-        start_sync sync;
-
-        state.PauseTiming();
-        sync.set_expected_count(producer_num + consumer_num);
-        auto consumers = create_consumers(*q, consumer_num, sync);
-        auto producers = create_producers(*q, producer_num, items_per_producer, sync);
-        sync.wait_until_all_ready();
-        state.ResumeTiming();
-
-        sync.notify_all();
-
-        producers.clear();
-        q->close();
-        consumers.clear();
+        consumed.store(0, std::memory_order_relaxed);
+        const phase_times& times = workers.run(task);
+        uint64_t elapsed = times.elapsed_ns();
+        uint64_t produced = times.elapsed_ns(0, producer_num);
+        state.SetIterationTime(static_cast<double>(elapsed) / 1e9);
+        produce_ns += static_cast<double>(produced);
+        drain_ns += static_cast<double>(elapsed > produced ? elapsed - produced : 0);
+        start_skew_ns += static_cast<double>(times.start_skew_ns());
+    }
+    perf.stop();
+
+    state.SetItemsProcessed(state.iterations() * total);
+    perf.report(state, static_cast<double>(state.iterations() * total));
+    state.counters["produce_ns"] = benchmark::Counter(produce_ns, benchmark::Counter::kAvgIterations);
+    state.counters["drain_ns"] = benchmark::Counter(drain_ns, benchmark::Counter::kAvgIterations);
+    state.counters["start_skew_ns"] = benchmark::Counter(start_skew_ns, benchmark::Counter::kAvgIterations);
+    if (!workers.pinned()) {
+        state.SetLabel("unpinned");
     }
-
-    state.SetItemsProcessed(state.iterations() * items_per_producer * producer_num);
 }
 
 template <typename QueueType>
@@ -144,13 +219,17 @@ void bm_near_full_90_percent(benchmark::State& state) {
     auto q = queue_factory<QueueType, QUEUE_CAPACITY>::create();
     fill_queue_to_percentage(*q, 0.9);
 
+    perf_counters perf;
+    perf.start();
     for (auto _ : state) {
         int value{};
         q->dequeue(value);
         q->enqueue(42);
     }
+    perf.stop();
 
     state.SetItemsProcessed(state.iterations() * 2);
+    perf.report(state, static_cast<double>(state.iterations() * 2));
     state.SetBytesProcessed(state.iterations() * 2 * sizeof(int));
 }
 
@@ -159,13 +238,17 @@ void bm_near_full_99_percent(benchmark::State& state) {
     auto q = queue_factory<QueueType, QUEUE_CAPACITY>::create();
     fill_queue_to_percentage(*q, 0.99);
 
+    perf_counters perf;
+    perf.start();
     for (auto _ : state) {
         int value{};
         q->dequeue(value);
         q->enqueue(42);
     }
+    perf.stop();
 
     state.SetItemsProcessed(state.iterations() * 2);
+    perf.report(state, static_cast<double>(state.iterations() * 2));
     state.SetBytesProcessed(state.iterations() * 2 * sizeof(int));
 }
 
@@ -174,11 +257,112 @@ void bm_empty_queue_try_dequeue(benchmark::State& state) {
     auto q = queue_factory<QueueType, QUEUE_CAPACITY>::create();
     int value{};
 
+    perf_counters perf;
+    perf.start();
     for (auto _ : state) {
         q->try_dequeue_with([&](int& v) {});
     }
+    perf.stop();
 
     state.SetItemsProcessed(state.iterations());
+    perf.report(state, static_cast<double>(state.iterations()));
+}
+
+struct mailbox_item : mpsc_hook {
+    size_t value{0};
+};
+
+inline mailbox_item* mailbox_pop(lock_queue<mailbox_item*>& queue) {
+    mailbox_item* item = nullptr;
+    return queue.dequeue(item) ? item : nullptr;
+}
+
+inline mailbox_item* mailbox_pop(mpsc_queue<mailbox_item>& queue) {
+    return queue.dequeue();
+}
+
+// Where the mailbox nodes come from: a vector filled before the run, new/delete per message, or
+// an FsmHandlePool of POOLED_NODE_COUNT nodes handed back by the consumer, which falls back to
+// the heap while all of them are in flight.
+enum class node_source : int64_t { preallocated = 0, heap = 1, pooled = 2 };
+
+static constexpr size_t POOLED_NODE_COUNT = 1024;
+
+// N producers pass items to one blocking consumer, the way events reach an FSM. The second
+// argument is the node_source. Workers 0..N-1 produce and worker N consumes; threads and mailbox
+// live for the whole benchmark and each iteration is timed from the first worker starting to the
+// last finishing.
+template <typename Mailbox>
+void bm_mailbox_mpsc(benchmark::State& state) {
+    size_t producer_num = state.range(0);
+    node_source source = static_cast<node_source>(state.range(1));
+    size_t item_num = producer_num * BULK_ITEM_COUNT;
+    std::vector<mailbox_item> items(source == node_source::preallocated ? item_num : 0);
+    FsmHandlePool<mailbox_item> pool(POOLED_NODE_COUNT);
+    Mailbox mailbox;
+
+    auto acquire = [&](size_t i) {
+        if (source == node_source::preallocated) {
+            return &items[i];
+        }
+        mailbox_item* item = source == node_source::pooled ? pool.Acquire() : nullptr;
+        if (!item) {
+            item = new mailbox_item();
+        }
+        item->value = i;
+        return item;
+    };
+    auto release = [&](mailbox_item* item) {
+        if (source == node_source::preallocated) {
+            return;
+        }
+        if (pool.Owns(item)) {
+            pool.Release(item);
+        } else {
+            delete item;
+        }
+    };
+
+    perf_counters perf;
+    pinned_worker_pool workers(producer_num + 1);
+    std::function<void(size_t)> task = [&](size_t worker) {
+        if (worker < producer_num) {
+            for (size_t i = worker * BULK_ITEM_COUNT; i < (worker + 1) * BULK_ITEM_COUNT; i++) {
+                mailbox.enqueue(acquire(i));
+            }
+            return;
+        }
+        size_t sum = 0;
+        for (size_t i = 0; i < item_num; i++) {
+            mailbox_item* item = mailbox_pop(mailbox);
+            sum += item->value;
+            release(item);
+        }
+        benchmark::DoNotOptimize(sum);
+    };
+
+    perf.start();
+    for (auto _ : state) {
+        const phase_times& times = workers.run(task);
+        state.SetIterationTime(static_cast<double>(times.elapsed_ns()) / 1e9);
+    }
+    perf.stop();
+
+    state.SetItemsProcessed(state.iterations() * item_num);
+    perf.report(state, static_cast<double>(state.iterations() * item_num));
+    if (!workers.pinned()) {
+        state.SetLabel("unpinned");
+    }
+}
+
+static void mailbox_args(benchmark::internal::Benchmark* bench) {
+    bench->ArgNames({"producers", "nodes"});
+    for (node_source source : {node_source::preallocated, node_source::heap, node_source::pooled}) {
+        for (int64_t producers : {1, 2, 4, 16}) {
+            bench->Args({producers, static_cast<int64_t>(source)});
+        }
+    }
+    bench->UseManualTime();
 }
 
 // ============================================================================
@@ -232,42 +416,42 @@ BENCHMARK_TEMPLATE(bm_capacity, lock_bounded_queue<int>)->Range(64, 4096);
 // ============================================================================
 // SPSC (Single Producer Single Consumer)
 // ============================================================================
-BENCHMARK(bm_spsc<lock_free_bounded_queue<int>>);
-BENCHMARK(bm_spsc<faa_bounded_queue<int>>);
-BENCHMARK(bm_spsc<ff_bounded_queue<int>>);
-BENCHMARK(bm_spsc<lock_bounded_queue<int>>);
-BENCHMARK(bm_spsc<lock_queue<int>>);
-BENCHMARK(bm_spsc<ms_queue<int>>);
+BENCHMARK(bm_spsc<lock_free_bounded_queue<int>>)->UseManualTime();
+BENCHMARK(bm_spsc<faa_bounded_queue<int>>)->UseManualTime();
+BENCHMARK(bm_spsc<ff_bounded_queue<int>>)->UseManualTime();
+BENCHMARK(bm_spsc<lock_bounded_queue<int>>)->UseManualTime();
+BENCHMARK(bm_spsc<lock_queue<int>>)->UseManualTime();
+BENCHMARK(bm_spsc<ms_queue<int>>)->UseManualTime();
 
 // ============================================================================
 // MPSC (Multiple Producers Single Consumer)
 // ============================================================================
-BENCHMARK_TEMPLATE(bm_mpsc, lock_free_bounded_queue<int>)->Args({2})->Args({4})->Args({16});
-BENCHMARK_TEMPLATE(bm_mpsc, faa_bounded_queue<int>)->Args({2})->Args({4})->Args({16});
-BENCHMARK_TEMPLATE(bm_mpsc, ff_bounded_queue<int>)->Args({2})->Args({4})->Args({16});
-BENCHMARK_TEMPLATE(bm_mpsc, lock_bounded_queue<int>)->Args({2})->Args({4})->Args({16});
-BENCHMARK_TEMPLATE(bm_mpsc, lock_queue<int>)->Args({2})->Args({4})->Args({16});
-BENCHMARK_TEMPLATE(bm_mpsc, ms_queue<int>)->Args({2})->Args({4})->Args({16});
+BENCHMARK_TEMPLATE(bm_mpsc, lock_free_bounded_queue<int>)->Args({2})->Args({4})->Args({16})->UseManualTime();
+BENCHMARK_TEMPLATE(bm_mpsc, faa_bounded_queue<int>)->Args({2})->Args({4})->Args({16})->UseManualTime();
+BENCHMARK_TEMPLATE(bm_mpsc, ff_bounded_queue<int>)->Args({2})->Args({4})->Args({16})->UseManualTime();
+BENCHMARK_TEMPLATE(bm_mpsc, lock_bounded_queue<int>)->Args({2})->Args({4})->Args({16})->UseManualTime();
+BENCHMARK_TEMPLATE(bm_mpsc, lock_queue<int>)->Args({2})->Args({4})->Args({16})->UseManualTime();
+BENCHMARK_TEMPLATE(bm_mpsc, ms_queue<int>)->Args({2})->Args({4})->Args({16})->UseManualTime();
 
 // ============================================================================
 // SPMC (Single Producer Multiple Consumers)
 // ============================================================================
-BENCHMARK_TEMPLATE(bm_spmc, lock_free_bounded_queue<int>)->Args({2})->Args({4})->Args({16});
-BENCHMARK_TEMPLATE(bm_spmc, faa_bounded_queue<int>)->Args({2})->Args({4})->Args({16});
-BENCHMARK_TEMPLATE(bm_spmc, ff_bounded_queue<int>)->Args({2})->Args({4})->Args({16});
-BENCHMARK_TEMPLATE(bm_spmc, lock_bounded_queue<int>)->Args({2})->Args({4})->Args({16});
-BENCHMARK_TEMPLATE(bm_spmc, lock_queue<int>)->Args({2})->Args({4})->Args({16});
-BENCHMARK_TEMPLATE(bm_spmc, ms_queue<int>)->Args({2})->Args({4})->Args({16});
+BENCHMARK_TEMPLATE(bm_spmc, lock_free_bounded_queue<int>)->Args({2})->Args({4})->Args({16})->UseManualTime();
+BENCHMARK_TEMPLATE(bm_spmc, faa_bounded_queue<int>)->Args({2})->Args({4})->Args({16})->UseManualTime();
+BENCHMARK_TEMPLATE(bm_spmc, ff_bounded_queue<int>)->Args({2})->Args({4})->Args({16})->UseManualTime();
+BENCHMARK_TEMPLATE(bm_spmc, lock_bounded_queue<int>)->Args({2})->Args({4})->Args({16})->UseManualTime();
+BENCHMARK_TEMPLATE(bm_spmc, lock_queue<int>)->Args({2})->Args({4})->Args({16})->UseManualTime();
+BENCHMARK_TEMPLATE(bm_spmc, ms_queue<int>)->Args({2})->Args({4})->Args({16})->UseManualTime();
 
 // ============================================================================
 // MPMC (Multiple Producers Multiple Consumers)
 // ============================================================================
-BENCHMARK_TEMPLATE(bm_mpmc, lock_free_bounded_queue<int>)->Args({2})->Args({4})->Args({16});
-BENCHMARK_TEMPLATE(bm_mpmc, faa_bounded_queue<int>)->Args({2})->Args({4})->Args({16});
-BENCHMARK_TEMPLATE(bm_mpmc, ff_bounded_queue<int>)->Args({2})->Args({4})->Args({16});
-BENCHMARK_TEMPLATE(bm_mpmc, lock_bounded_queue<int>)->Args({2})->Args({4})->Args({16});
-BENCHMARK_TEMPLATE(bm_mpmc, lock_queue<int>)->Args({2})->Args({4})->Args({16});
-BENCHMARK_TEMPLATE(bm_mpmc, ms_queue<int>)->Args({2})->Args({4})->Args({16});
+BENCHMARK_TEMPLATE(bm_mpmc, lock_free_bounded_queue<int>)->Args({2})->Args({4})->Args({16})->UseManualTime();
+BENCHMARK_TEMPLATE(bm_mpmc, faa_bounded_queue<int>)->Args({2})->Args({4})->Args({16})->UseManualTime();
+BENCHMARK_TEMPLATE(bm_mpmc, ff_bounded_queue<int>)->Args({2})->Args({4})->Args({16})->UseManualTime();
+BENCHMARK_TEMPLATE(bm_mpmc, lock_bounded_queue<int>)->Args({2})->Args({4})->Args({16})->UseManualTime();
+BENCHMARK_TEMPLATE(bm_mpmc, lock_queue<int>)->Args({2})->Args({4})->Args({16})->UseManualTime();
+BENCHMARK_TEMPLATE(bm_mpmc, ms_queue<int>)->Args({2})->Args({4})->Args({16})->UseManualTime();
 
 // ============================================================================
 // Near Full Queue - 90%
@@ -298,3 +482,9 @@ BENCHMARK(bm_empty_queue_try_dequeue<ff_bounded_queue<int>>);
 BENCHMARK(bm_empty_queue_try_dequeue<lock_bounded_queue<int>>);
 BENCHMARK(bm_empty_queue_try_dequeue<ms_queue<int>>);
 BENCHMARK(bm_empty_queue_try_dequeue<lock_queue<int>>);
+
+// ============================================================================
+// MPSC Mailbox - intrusive mpsc_queue vs lock_queue
+// ============================================================================
+BENCHMARK_TEMPLATE(bm_mailbox_mpsc, mpsc_queue<mailbox_item>)->Apply(mailbox_args);
+BENCHMARK_TEMPLATE(bm_mailbox_mpsc, lock_queue<mailbox_item*>)->Apply(mailbox_args);
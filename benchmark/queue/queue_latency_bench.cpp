@@ -0,0 +1,194 @@
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "opt/histogram.h"
+#include "queue/faa_bounded_queue.h"
+#include "queue/ff_bounded_queue.h"
+#include "queue/lock_bounded_queue.h"
+#include "queue/lock_free_bounded_queue.h"
+#include "queue/lock_queue.h"
+#include "queue/mpsc_queue.h"
+#include "queue/ms_queue.h"
+#include "perf_counters.h"
+#include "pinned_workers.h"
+#include "queue_factory.h"
+#include "queue_helpers.h"
+
+constexpr size_t LATENCY_ITEM_COUNT = 1024 * 16;
+
+// 16 linear sub-buckets per power of two, i.e. percentiles within ~6%.
+constexpr size_t LATENCY_SUB_BUCKET_BITS = 4;
+using latency_histogram = log_histogram<LATENCY_SUB_BUCKET_BITS>;
+using latency_snapshot = histogram_snapshot<LATENCY_SUB_BUCKET_BITS>;
+
+static uint64_t steady_now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+}
+
+// What a benchmark keeps across runs for its queue: nothing for value queues, which carry the
+// timestamp itself.
+template <typename Queue>
+struct latency_storage {
+    explicit latency_storage(size_t) {}
+};
+
+// One run's queue, passing enqueue timestamps.
+template <typename Queue>
+class latency_queue {
+   public:
+    explicit latency_queue(latency_storage<Queue>&) : q_(queue_factory<Queue, QUEUE_CAPACITY>::create()) {}
+
+    void push(size_t) {
+        q_->enqueue(steady_now_ns());
+    }
+    bool pop(uint64_t& enqueued_ns) {
+        return q_->dequeue(enqueued_ns);
+    }
+    void close() {
+        q_->close();
+    }
+
+   private:
+    std::unique_ptr<Queue> q_;
+};
+
+struct latency_node : mpsc_hook {
+    uint64_t enqueued_ns{0};
+};
+
+template <>
+struct latency_storage<mpsc_queue<latency_node>> {
+    explicit latency_storage(size_t item_num) : nodes(item_num) {}
+    std::vector<latency_node> nodes;
+};
+
+// The intrusive mpsc_queue carries nodes, one per item of the run, allocated once per benchmark
+// and reused by every run; nodes[slot] is only touched by the producer owning that slot.
+template <>
+class latency_queue<mpsc_queue<latency_node>> {
+   public:
+    explicit latency_queue(latency_storage<mpsc_queue<latency_node>>& storage) : nodes_(storage.nodes) {}
+
+    void push(size_t slot) {
+        nodes_[slot].enqueued_ns = steady_now_ns();
+        q_.enqueue(&nodes_[slot]);
+    }
+    bool pop(uint64_t& enqueued_ns) {
+        latency_node* node = q_.dequeue();
+        if (!node) {
+            return false;
+        }
+        enqueued_ns = node->enqueued_ns;
+        return true;
+    }
+    void close() {
+        q_.close();
+    }
+
+   private:
+    std::vector<latency_node>& nodes_;
+    mpsc_queue<latency_node> q_;
+};
+
+// Every item is the steady_clock time of its enqueue; consumers record now - item into a
+// histogram of their own, merged once at the end. Producers run flat out, so with a bounded
+// queue the numbers include the wait behind a full buffer: this is latency under saturation,
+// not of an idle queue.
+//
+// Workers 0..producer_num-1 produce, the rest consume with the blocking dequeue(). Threads live
+// for the whole benchmark; each run gets a fresh queue, created before the workers are released,
+// which the last producer to finish closes. Runs are timed from the first worker starting to
+// the last finishing.
+template <typename Queue>
+void run_latency_benchmark(benchmark::State& state, size_t producer_num, size_t consumer_num) {
+    latency_storage<Queue> storage(producer_num * LATENCY_ITEM_COUNT);
+    std::unique_ptr<latency_histogram[]> histograms(new latency_histogram[consumer_num]);
+    std::unique_ptr<latency_queue<Queue>> q;
+    std::atomic<size_t> producing{0};
+    perf_counters perf;
+    pinned_worker_pool workers(producer_num + consumer_num);
+
+    std::function<void(size_t)> task = [&](size_t worker) {
+        if (worker < producer_num) {
+            for (size_t i = worker * LATENCY_ITEM_COUNT; i < (worker + 1) * LATENCY_ITEM_COUNT; i++) {
+                q->push(i);
+            }
+            if (producing.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                q->close();
+            }
+        } else {
+            latency_histogram& histogram = histograms[worker - producer_num];
+            uint64_t enqueued_ns = 0;
+            while (q->pop(enqueued_ns)) {
+                histogram.record(steady_now_ns() - enqueued_ns);
+            }
+        }
+    };
+
+    perf.start();
+    for (auto _ : state) {
+        q.reset(new latency_queue<Queue>(storage));
+        producing.store(producer_num, std::memory_order_relaxed);
+        const phase_times& times = workers.run(task);
+        state.SetIterationTime(static_cast<double>(times.elapsed_ns()) / 1e9);
+    }
+    perf.stop();
+
+    latency_snapshot total;
+    for (size_t c = 0; c < consumer_num; c++) {
+        total.merge(histograms[c].snapshot());
+    }
+    state.SetItemsProcessed(state.iterations() * LATENCY_ITEM_COUNT * producer_num);
+    perf.report(state, static_cast<double>(state.iterations() * LATENCY_ITEM_COUNT * producer_num));
+    state.counters["p50_ns"] = static_cast<double>(total.percentile(50.0));
+    state.counters["p99_ns"] = static_cast<double>(total.percentile(99.0));
+    state.counters["p999_ns"] = static_cast<double>(total.percentile(99.9));
+    state.counters["max_ns"] = static_cast<double>(total.max);
+    state.counters["mean_ns"] = total.mean();
+    if (!workers.pinned()) {
+        state.SetLabel("unpinned");
+    }
+}
+
+template <typename QueueType>
+void bm_latency(benchmark::State& state) {
+    size_t producer_num = state.range(0);
+    size_t consumer_num = state.range(1);
+    if (producer_num == 0 || consumer_num == 0) {
+        state.SkipWithError("Need at least 1 producer and 1 consumer");
+        return;
+    }
+    run_latency_benchmark<QueueType>(state, producer_num, consumer_num);
+}
+
+static void latency_mixes(benchmark::internal::Benchmark* bench) {
+    bench->ArgNames({"producers", "consumers"});
+    bench->Args({1, 1})->Args({4, 1})->Args({1, 4})->Args({4, 4});
+    bench->UseManualTime();
+}
+
+// mpsc_queue has a single consumer.
+static void latency_mixes_mpsc(benchmark::internal::Benchmark* bench) {
+    bench->ArgNames({"producers", "consumers"});
+    bench->Args({1, 1})->Args({4, 1});
+    bench->UseManualTime();
+}
+
+// ============================================================================
+// Enqueue-to-Dequeue Latency (p50 / p99 / p99.9 / max as counters)
+// ============================================================================
+BENCHMARK_TEMPLATE(bm_latency, lock_free_bounded_queue<uint64_t>)->Apply(latency_mixes);
+BENCHMARK_TEMPLATE(bm_latency, faa_bounded_queue<uint64_t>)->Apply(latency_mixes);
+BENCHMARK_TEMPLATE(bm_latency, ff_bounded_queue<uint64_t>)->Apply(latency_mixes);
+BENCHMARK_TEMPLATE(bm_latency, lock_bounded_queue<uint64_t>)->Apply(latency_mixes);
+BENCHMARK_TEMPLATE(bm_latency, lock_queue<uint64_t>)->Apply(latency_mixes);
+BENCHMARK_TEMPLATE(bm_latency, ms_queue<uint64_t>)->Apply(latency_mixes);
+BENCHMARK_TEMPLATE(bm_latency, mpsc_queue<latency_node>)->Apply(latency_mixes_mpsc);
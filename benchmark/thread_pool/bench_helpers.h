@@ -0,0 +1,45 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+using bench_clock = std::chrono::steady_clock;
+
+constexpr size_t TASK_BATCH = 1024;
+constexpr int64_t FAN_OUT_SMALL = 64;
+constexpr int64_t FAN_OUT_LARGE = 4096;
+constexpr int64_t SPAWN_DEPTH = 12;
+
+inline void spin_for(std::chrono::nanoseconds duration) {
+    auto until = bench_clock::now() + duration;
+    while (bench_clock::now() < until) {
+    }
+}
+
+// Fixed, repeating mix: 90% trivial (~100ns), 9% 1us, 1% 10us, so a short task can get stuck
+// behind a long one in most batches.
+inline std::chrono::nanoseconds mixed_duration(size_t i) {
+    size_t slot = i % 100;
+    if (slot == 0) {
+        return std::chrono::microseconds(10);
+    }
+    if (slot < 10) {
+        return std::chrono::microseconds(1);
+    }
+    return std::chrono::nanoseconds(100);
+}
+
+// range(0) is the worker count in every suite benchmark.
+inline void worker_counts(benchmark::internal::Benchmark* bench) {
+    bench->ArgName("workers")->Arg(1)->Arg(2)->Arg(4)->Arg(8);
+}
+
+inline void worker_counts_fan_out(benchmark::internal::Benchmark* bench) {
+    bench->ArgNames({"workers", "tasks"});
+    for (int64_t workers : {1, 2, 4, 8}) {
+        bench->Args({workers, FAN_OUT_SMALL})->Args({workers, FAN_OUT_LARGE});
+    }
+}
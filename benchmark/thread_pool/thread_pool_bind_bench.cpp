@@ -0,0 +1,195 @@
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "bench_helpers.h"
+#include "thread_pool/thread_pool_bind.h"
+
+namespace {
+
+// Keeps the LOW lane saturated with short tasks for as long as it lives.
+class low_priority_flood {
+   public:
+    low_priority_flood(ThreadPool& pool, size_t backlog) : pool_(pool), backlog_(backlog) {
+        thread_ = std::thread([this]() { run(); });
+    }
+    ~low_priority_flood() {
+        stop_.store(true);
+        thread_.join();
+    }
+
+   private:
+    void run() {
+        while (!stop_.load(std::memory_order_relaxed)) {
+            if (inflight_.load(std::memory_order_relaxed) >= backlog_) {
+                std::this_thread::yield();
+                continue;
+            }
+            inflight_.fetch_add(1, std::memory_order_relaxed);
+            pool_.PostPriority(ThreadPool::Priority::LOW, [this]() {
+                spin_for(std::chrono::microseconds(2));
+                inflight_.fetch_sub(1, std::memory_order_relaxed);
+            });
+        }
+    }
+
+    ThreadPool& pool_;
+    const size_t backlog_;
+    std::atomic<size_t> inflight_{0};
+    std::atomic<bool> stop_{false};
+    std::thread thread_;
+};
+
+// Every node of a binary tree of the given depth is a task that posts its two children.
+void spawn_tree(ThreadPool& pool, JoinCounter& counter, int64_t depth) {
+    if (depth > 0) {
+        for (int child = 0; child < 2; child++) {
+            pool.Post([&pool, &counter, depth]() { spawn_tree(pool, counter, depth - 1); });
+        }
+    }
+    counter.Done();
+}
+
+}  // namespace
+
+// Fire-and-forget submission of TASK_BATCH empty tasks and one join.
+void bm_bind_post_empty(benchmark::State& state) {
+    ThreadPool pool(state.range(0));
+
+    for (auto _ : state) {
+        JoinCounter counter(TASK_BATCH);
+        for (size_t i = 0; i < TASK_BATCH; i++) {
+            pool.Post([&counter]() { counter.Done(); });
+        }
+        counter.Wait();
+    }
+
+    state.SetItemsProcessed(state.iterations() * TASK_BATCH);
+}
+
+// Same with a future per task, the usual Push path.
+void bm_bind_push_empty(benchmark::State& state) {
+    ThreadPool pool(state.range(0));
+    std::vector<std::future<void>> futures;
+    futures.reserve(TASK_BATCH);
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < TASK_BATCH; i++) {
+            futures.push_back(pool.Push([]() {}));
+        }
+        for (std::future<void>& fut : futures) {
+            fut.wait();
+        }
+        futures.clear();
+    }
+
+    state.SetItemsProcessed(state.iterations() * TASK_BATCH);
+}
+
+// Submit-to-start latency of back-to-back tasks, i.e. with a worker still spinning.
+void bm_bind_submit_latency(benchmark::State& state) {
+    ThreadPool pool(state.range(0));
+
+    for (auto _ : state) {
+        bench_clock::time_point started;
+        bench_clock::time_point submitted = bench_clock::now();
+        pool.Push([&started]() { started = bench_clock::now(); }).wait();
+        state.SetIterationTime(std::chrono::duration<double>(started - submitted).count());
+    }
+}
+
+// range(1) tasks of about 1us each, joined by the submitting thread, which helps meanwhile.
+void bm_bind_fan_out_fan_in(benchmark::State& state) {
+    ThreadPool pool(state.range(0));
+    size_t task_num = state.range(1);
+
+    for (auto _ : state) {
+        JoinCounter counter(task_num);
+        for (size_t i = 0; i < task_num; i++) {
+            pool.Post([&counter]() {
+                spin_for(std::chrono::microseconds(1));
+                counter.Done();
+            });
+        }
+        pool.Join(counter);
+    }
+
+    state.SetItemsProcessed(state.iterations() * task_num);
+}
+
+// Tasks submitted from inside tasks: a binary tree of SPAWN_DEPTH levels.
+void bm_bind_recursive_spawn(benchmark::State& state) {
+    ThreadPool pool(state.range(0));
+    size_t node_num = (size_t{1} << (SPAWN_DEPTH + 1)) - 1;
+
+    for (auto _ : state) {
+        JoinCounter counter(node_num);
+        pool.Post([&pool, &counter]() { spawn_tree(pool, counter, SPAWN_DEPTH); });
+        pool.Join(counter);
+    }
+
+    state.SetItemsProcessed(state.iterations() * node_num);
+}
+
+// TASK_BATCH tasks following mixed_duration().
+void bm_bind_mixed_durations(benchmark::State& state) {
+    ThreadPool pool(state.range(0));
+
+    for (auto _ : state) {
+        JoinCounter counter(TASK_BATCH);
+        for (size_t i = 0; i < TASK_BATCH; i++) {
+            pool.Post([&counter, i]() {
+                spin_for(mixed_duration(i));
+                counter.Done();
+            });
+        }
+        pool.Join(counter);
+    }
+
+    state.SetItemsProcessed(state.iterations() * TASK_BATCH);
+}
+
+// Submit-to-start latency of a single probe task while the LOW lane is saturated.
+// range(0) is the lane of the probe: 0 = HIGH, 1 = NORMAL, 2 = LOW.
+void bm_priority_latency_under_flood(benchmark::State& state) {
+    auto priority = static_cast<ThreadPool::Priority>(state.range(0));
+    ThreadPool pool(ThreadPool::THREAD_NUM_DEFAULT);
+    low_priority_flood flood(pool, 1024);
+
+    for (auto _ : state) {
+        bench_clock::time_point started;
+        bench_clock::time_point submitted = bench_clock::now();
+        pool.PushPriority(priority, [&started]() { started = bench_clock::now(); }).wait();
+        state.SetIterationTime(std::chrono::duration<double>(started - submitted).count());
+    }
+
+    pool.Destroy();
+}
+
+// Submit-to-start latency when tasks arrive one at a time with range(0) microseconds of idle
+// time in between, i.e. the workers have gone through spinning and are usually parked.
+void bm_idle_wakeup_latency(benchmark::State& state) {
+    auto gap = std::chrono::microseconds(state.range(0));
+    ThreadPool pool(ThreadPool::THREAD_NUM_DEFAULT);
+
+    for (auto _ : state) {
+        std::this_thread::sleep_for(gap);
+        bench_clock::time_point started;
+        bench_clock::time_point submitted = bench_clock::now();
+        pool.Push([&started]() { started = bench_clock::now(); }).wait();
+        state.SetIterationTime(std::chrono::duration<double>(started - submitted).count());
+    }
+}
+
+BENCHMARK(bm_priority_latency_under_flood)->Arg(0)->Arg(1)->Arg(2)->UseManualTime()->Unit(benchmark::kMicrosecond);
+BENCHMARK(bm_idle_wakeup_latency)->Arg(0)->Arg(10)->Arg(100)->Arg(1000)->UseManualTime()->Unit(benchmark::kMicrosecond);
+BENCHMARK(bm_bind_post_empty)->Apply(worker_counts)->UseRealTime();
+BENCHMARK(bm_bind_push_empty)->Apply(worker_counts)->UseRealTime();
+BENCHMARK(bm_bind_submit_latency)->Apply(worker_counts)->UseManualTime()->Unit(benchmark::kMicrosecond);
+BENCHMARK(bm_bind_fan_out_fan_in)->Apply(worker_counts_fan_out)->UseRealTime()->Unit(benchmark::kMicrosecond);
+BENCHMARK(bm_bind_recursive_spawn)->Apply(worker_counts)->UseRealTime()->Unit(benchmark::kMicrosecond);
+BENCHMARK(bm_bind_mixed_durations)->Apply(worker_counts)->UseRealTime()->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,122 @@
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <vector>
+
+#include "bench_helpers.h"
+#include "thread_pool/join_counter.h"
+#include "thread_pool/thread_pool.h"
+
+// ThreadPool<Data> lives in its own translation unit: it shares the name of the bind pool.
+
+namespace {
+
+struct latency_probe {
+    bench_clock::time_point started;
+};
+
+struct spawn_job {
+    int64_t depth{0};
+    JoinCounter* counter{nullptr};
+};
+
+}  // namespace
+
+// TASK_BATCH submissions through a no-op callback, waiting on every future.
+void bm_data_submit_empty(benchmark::State& state) {
+    ThreadPool<int> pool(state.range(0), [](int&) {});
+    std::vector<std::future<int>> futures;
+    futures.reserve(TASK_BATCH);
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < TASK_BATCH; i++) {
+            futures.push_back(pool.Submit(static_cast<int>(i)));
+        }
+        for (std::future<int>& fut : futures) {
+            fut.wait();
+        }
+        futures.clear();
+    }
+
+    state.SetItemsProcessed(state.iterations() * TASK_BATCH);
+}
+
+// Submit-to-callback latency of back-to-back jobs.
+void bm_data_submit_latency(benchmark::State& state) {
+    ThreadPool<latency_probe> pool(state.range(0), [](latency_probe& probe) { probe.started = bench_clock::now(); });
+
+    for (auto _ : state) {
+        bench_clock::time_point submitted = bench_clock::now();
+        latency_probe probe = pool.Submit(latency_probe()).get();
+        state.SetIterationTime(std::chrono::duration<double>(probe.started - submitted).count());
+    }
+}
+
+// range(1) jobs of about 1us each; the submitter only waits, this pool has no helping join.
+void bm_data_fan_out_fan_in(benchmark::State& state) {
+    ThreadPool<int> pool(state.range(0), [](int&) { spin_for(std::chrono::microseconds(1)); });
+    size_t task_num = state.range(1);
+    std::vector<std::future<int>> futures;
+    futures.reserve(task_num);
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < task_num; i++) {
+            futures.push_back(pool.Submit(static_cast<int>(i)));
+        }
+        for (std::future<int>& fut : futures) {
+            fut.wait();
+        }
+        futures.clear();
+    }
+
+    state.SetItemsProcessed(state.iterations() * task_num);
+}
+
+// Jobs submitted from the callback: a binary tree of SPAWN_DEPTH levels.
+void bm_data_recursive_spawn(benchmark::State& state) {
+    ThreadPool<spawn_job>* self = nullptr;
+    ThreadPool<spawn_job> pool(state.range(0), [&self](spawn_job& job) {
+        if (job.depth > 0) {
+            self->Submit(spawn_job{job.depth - 1, job.counter});
+            self->Submit(spawn_job{job.depth - 1, job.counter});
+        }
+        job.counter->Done();
+    });
+    self = &pool;
+    size_t node_num = (size_t{1} << (SPAWN_DEPTH + 1)) - 1;
+
+    for (auto _ : state) {
+        JoinCounter counter(node_num);
+        pool.Submit(spawn_job{SPAWN_DEPTH, &counter});
+        counter.Wait();
+    }
+
+    state.SetItemsProcessed(state.iterations() * node_num);
+}
+
+// TASK_BATCH jobs following mixed_duration().
+void bm_data_mixed_durations(benchmark::State& state) {
+    ThreadPool<size_t> pool(state.range(0), [](size_t& i) { spin_for(mixed_duration(i)); });
+    std::vector<std::future<size_t>> futures;
+    futures.reserve(TASK_BATCH);
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < TASK_BATCH; i++) {
+            futures.push_back(pool.Submit(size_t{i}));
+        }
+        for (std::future<size_t>& fut : futures) {
+            fut.wait();
+        }
+        futures.clear();
+    }
+
+    state.SetItemsProcessed(state.iterations() * TASK_BATCH);
+}
+
+BENCHMARK(bm_data_submit_empty)->Apply(worker_counts)->UseRealTime();
+BENCHMARK(bm_data_submit_latency)->Apply(worker_counts)->UseManualTime()->Unit(benchmark::kMicrosecond);
+BENCHMARK(bm_data_fan_out_fan_in)->Apply(worker_counts_fan_out)->UseRealTime()->Unit(benchmark::kMicrosecond);
+BENCHMARK(bm_data_recursive_spawn)->Apply(worker_counts)->UseRealTime()->Unit(benchmark::kMicrosecond);
+BENCHMARK(bm_data_mixed_durations)->Apply(worker_counts)->UseRealTime()->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <type_traits>
+
+#include "fsm/state_table.h"
+
+// Dense tables indexed directly by the enum values, which must be contiguous from 0.
+// Lookups are a bounds check plus an array access instead of std::map searches.
+
+template <typename State, typename Event, size_t NStates,
+          typename std::enable_if<std::is_enum<State>::value, bool>::type = true,
+          typename std::enable_if<std::is_enum<Event>::value, bool>::type = true>
+class FsmDenseStateTable {
+   public:
+    FsmDenseStateTable() = default;
+    explicit FsmDenseStateTable(const StateTable<State, Event>* table) {
+        if (!table) {
+            return;
+        }
+        for (const auto& [state, fsmState] : *table) {
+            if (static_cast<size_t>(state) < NStates) {
+                states_[static_cast<size_t>(state)] = fsmState;
+            }
+        }
+    }
+    void Entry(State state, Event event) {
+        Invoke(state, &FsmState<State, Event>::entry_, event);
+    }
+    void Exit(State state, Event event) {
+        Invoke(state, &FsmState<State, Event>::exit_, event);
+    }
+    void Callback(State state, Event event) {
+        Invoke(state, &FsmState<State, Event>::callback_, event);
+    }
+
+   private:
+    void Invoke(State state, Action<Event> FsmState<State, Event>::*action, Event event) {
+        size_t index = static_cast<size_t>(state);
+        if (index < NStates && states_[index].*action) {
+            (states_[index].*action)(event);
+        }
+    }
+
+   private:
+    std::array<FsmState<State, Event>, NStates> states_;
+};
+
+// Can be built at compile time from a transition list:
+//   constexpr FsmDenseChangeTable<S, E, 3, 2> table{{{S::A, E::GO, S::B}, {S::B, E::GO, S::C}}};
+template <typename State, typename Event, size_t NStates, size_t NEvents,
+          typename std::enable_if<std::is_enum<State>::value, bool>::type = true,
+          typename std::enable_if<std::is_enum<Event>::value, bool>::type = true>
+class FsmDenseChangeTable {
+   public:
+    struct Transition {
+        State from;
+        Event event;
+        State to;
+    };
+
+   public:
+    constexpr FsmDenseChangeTable() : toStates_() {
+        for (size_t i = 0; i < NStates * NEvents; i++) {
+            toStates_[i] = NONE;
+        }
+    }
+    constexpr FsmDenseChangeTable(std::initializer_list<Transition> transitions) : FsmDenseChangeTable() {
+        for (const Transition& transition : transitions) {
+            Set(transition.from, transition.event, transition.to);
+        }
+    }
+    explicit FsmDenseChangeTable(const StateChangeTable<State, Event>* table) : FsmDenseChangeTable() {
+        if (!table) {
+            return;
+        }
+        for (const auto& [state, eventTable] : *table) {
+            for (const auto& [event, toState] : eventTable) {
+                Set(state, event, toState);
+            }
+        }
+    }
+
+    constexpr bool Valid(State state, Event event) const {
+        State toState = NONE;
+        return GetTostate(state, event, toState);
+    }
+    constexpr bool GetTostate(State state, Event event, State& toState) const {
+        size_t s = static_cast<size_t>(state);
+        size_t e = static_cast<size_t>(event);
+        if (s >= NStates || e >= NEvents || toStates_[s * NEvents + e] == NONE) {
+            return false;
+        }
+        toState = toStates_[s * NEvents + e];
+        return true;
+    }
+
+   private:
+    constexpr void Set(State state, Event event, State toState) {
+        size_t s = static_cast<size_t>(state);
+        size_t e = static_cast<size_t>(event);
+        if (s < NStates && e < NEvents && static_cast<size_t>(toState) < NStates) {
+            toStates_[s * NEvents + e] = toState;
+        }
+    }
+
+   private:
+    // One past the last state marks a missing transition.
+    static constexpr State NONE = static_cast<State>(NStates);
+    std::array<State, NStates * NEvents> toStates_;
+};
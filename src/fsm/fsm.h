@@ -1,30 +1,66 @@
 #pragma once
 
 #include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <thread>
+#include <vector>
 
+#include "fsm/dense_table.h"
+#include "fsm/fsm_handle_pool.h"
+#include "fsm/fsm_snapshot.h"
+#include "fsm/fsm_tracer.h"
 #include "fsm/state_table.h"
-#include "queue/lock_queue.h"
+#include "fsm/static_table.h"
+#include "queue/mpsc_queue.h"
 
-template <typename State, typename Event>
+// Dispatcher decides what an event does, e.g. FsmDispatcher over FsmDenseStateTable and
+// FsmDenseChangeTable for O(1) lookups. The default keeps using the std::map tables.
+template <typename State, typename Event, typename Dispatcher = FsmDispatcher<State, Event>>
 class FSM {
    public:
-    FSM(StateTable<State, Event>* stateTable, StateChangeTable<State, Event>* changeTable, State initial) {
+    // Mailbox handles preallocated per FSM unless the constructor is given another count; beyond
+    // that many events in flight they come from the heap. Kept small so dormant FSMs stay cheap.
+    static constexpr size_t HANDLE_POOL_SIZE_DEFAULT = 16;
+
+   public:
+    FSM(StateTable<State, Event>* stateTable, StateChangeTable<State, Event>* changeTable, State initial,
+        size_t handlePoolSize = HANDLE_POOL_SIZE_DEFAULT)
+        : FSM(Dispatcher(stateTable, changeTable), initial, handlePoolSize) {}
+    FSM(Dispatcher dispatcher, State initial, size_t handlePoolSize = HANDLE_POOL_SIZE_DEFAULT)
+        : dispatcher_(std::move(dispatcher)), handles_(handlePoolSize) {
         curState_.store(initial);
         ready_.store(true);
-        pooling_ = std::async(std::launch::async, FSMProcessor(this, stateTable, changeTable));
-
-        while (!threadStarted_.load()) {
-            std::this_thread::yield();
+        // Events submitted before the processor runs simply wait in the queue.
+        pooling_ = std::async(std::launch::async, FSMProcessor(this));
+    }
+    // Continues from a snapshot: starts in its state and handles its pending events first.
+    FSM(StateTable<State, Event>* stateTable, StateChangeTable<State, Event>* changeTable,
+        const FsmSnapshot<State, Event>& snapshot, size_t handlePoolSize = HANDLE_POOL_SIZE_DEFAULT)
+        : FSM(Dispatcher(stateTable, changeTable), snapshot, handlePoolSize) {}
+    FSM(Dispatcher dispatcher, const FsmSnapshot<State, Event>& snapshot,
+        size_t handlePoolSize = HANDLE_POOL_SIZE_DEFAULT)
+        : FSM(std::move(dispatcher), snapshot.state, handlePoolSize) {
+        for (Event event : snapshot.pending) {
+            Post(event);
         }
-
-        pause_.store(false);
     }
     ~FSM() {
-        ready_.store(false);
+        {
+            std::lock_guard<std::mutex> lock(pauseMtx_);
+            ready_.store(false);
+        }
+        pauseCv_.notify_all();
         queue_.close();
         pooling_.wait();
+        while (Handle* handle = queue_.try_dequeue()) {
+            FreeHandle(handle);
+        }
     }
     FSM(const FSM&) = delete;
     FSM(FSM&&) = delete;
@@ -32,65 +68,267 @@ class FSM {
     FSM& operator=(FSM&&) = delete;
 
     std::future<void> Submit(Event event) {
-        Handle handle(event, std::promise<void>());
-        std::future<void> fut = handle.second.get_future();
-        queue_.enqueue(std::move(handle));
+        Handle* handle = NewHandle(event);
+        std::future<void> fut = handle->prms.emplace().get_future();
+        Enqueue(handle);
         return fut;
     }
+    // No completion is reported, so no promise is allocated; with a pooled handle nothing is.
+    void Post(Event event) {
+        Enqueue(NewHandle(event));
+    }
+    // Queued with a single exchange on the mailbox; the future is ready once the last event is handled.
+    std::future<void> SubmitBatch(const Event* events, size_t count) {
+        std::promise<void> prms;
+        std::future<void> fut = prms.get_future();
+        if (count == 0) {
+            prms.set_value();
+            return fut;
+        }
+        std::vector<Handle*> handles;
+        handles.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            handles.push_back(NewHandle(events[i]));
+        }
+        handles.back()->prms.emplace(std::move(prms));
+        if (!queue_.enqueue_bulk(handles.data(), handles.size())) {
+            for (Handle* handle : handles) {
+                FreeHandle(handle);
+            }
+        }
+        return fut;
+    }
+    std::future<void> SubmitBatch(const std::vector<Event>& events) {
+        return SubmitBatch(events.data(), events.size());
+    }
     State GetState() {
         return curState_.load();
     }
+    // While paused, events are still accepted but not handled; the processor sleeps on a condition
+    // variable and costs no CPU. An event already being handled when Pause() is called completes.
+    void Pause() {
+        std::lock_guard<std::mutex> lock(pauseMtx_);
+        pause_.store(true);
+    }
+    void Resume() {
+        {
+            std::lock_guard<std::mutex> lock(pauseMtx_);
+            pause_.store(false);
+        }
+        pauseCv_.notify_all();
+    }
+    bool Paused() const {
+        return pause_.load();
+    }
+    // State plus the events queued but not handled yet, taken by the processor between two events.
+    // Works while paused as well. Pending events stay queued and are still handled afterwards.
+    std::future<FsmSnapshot<State, Event>> Snapshot() {
+        Handle* handle = NewHandle(Event());
+        handle->snapshot = std::make_unique<std::promise<FsmSnapshot<State, Event>>>();
+        std::future<FsmSnapshot<State, Event>> fut = handle->snapshot->get_future();
+        if (!queue_.enqueue(handle)) {
+            FreeHandle(handle);
+            return fut;
+        }
+        // Counted only once linked, so a paused processor woken for it always finds it.
+        {
+            std::lock_guard<std::mutex> lock(pauseMtx_);
+            snapshotWaiting_++;
+        }
+        pauseCv_.notify_all();
+        return fut;
+    }
+    // Tracing is off while no tracer is set. The tracer must outlive the FSM or be reset to
+    // nullptr first; it may only be attached to one FSM at a time.
+    void SetTracer(FsmTracer<State, Event>* tracer) {
+        tracer_.store(tracer, std::memory_order_release);
+    }
 
    private:
     class FSMProcessor {
        public:
-        FSMProcessor(FSM<State, Event>* fsm, StateTable<State, Event>* stateTable,
-                     StateChangeTable<State, Event>* changeTable)
-            : fsm_(fsm), stateTable_(stateTable), changeTable_(changeTable) {}
+        explicit FSMProcessor(FSM* fsm) : fsm_(fsm) {}
         void operator()() {
             if (!fsm_) {
                 return;
             }
-            fsm_->threadStarted_.store(true);
+            // dequeue() only parks once the mailbox is empty, every event already there is taken
+            // without any lock. A snapshot moves the mailbox into backlog, which is handled first.
+            std::deque<Handle*> backlog;
             while (fsm_->ready_.load()) {
-                if (fsm_->pause_.load()) {
+                Handle* handle = nullptr;
+                if (!backlog.empty()) {
+                    handle = backlog.front();
+                    backlog.pop_front();
+                } else if (!(handle = fsm_->queue_.dequeue())) {
+                    break;  // Queue closed, exit loop
+                }
+                if (handle->snapshot) {
+                    fsm_->ServeSnapshots(handle, nullptr, backlog);
                     continue;
                 }
-                std::optional<Handle> handle = fsm_->queue_.dequeue();
-                if (!handle) {
-                    break;  // Queue closed, exit loop
+                if (!fsm_->WaitWhilePaused(handle, backlog)) {
+                    fsm_->FreeHandle(handle);
+                    break;  // Destroyed while paused
+                }
+                FsmTracer<State, Event>* tracer = fsm_->tracer_.load(std::memory_order_acquire);
+                uint64_t startNs = tracer ? tracer->Now() : 0;
+                State fromState = fsm_->curState_.load();
+                State toState = fromState;
+                if (fsm_->dispatcher_.Dispatch(fromState, handle->event, toState)) {
+                    fsm_->curState_.store(toState);
+                } else {
+                    toState = fromState;
+                }
+                if (tracer) {
+                    tracer->Record(fromState, handle->event, toState, startNs, tracer->Now());
+                }
+                if (handle->prms) {
+                    handle->prms->set_value();
                 }
-                stateTable_.Callback(fsm_->curState_.load(), handle.value().first);
-                ChangeState(handle.value().first);
-                handle.value().second.set_value();
+                fsm_->FreeHandle(handle);
             }
-        }
-
-       private:
-        void ChangeState(Event event) {
-            State toState;
-            if (changeTable_.GetTostate(fsm_->curState_.load(), event, toState)) {
-                stateTable_.Exit(fsm_->curState_.load(), event);
-                stateTable_.Entry(toState, event);
-                stateTable_.Callback(toState, event);
-                fsm_->curState_.store(toState);
+            for (Handle* handle : backlog) {
+                fsm_->FreeHandle(handle);
             }
-        };
+        }
 
        private:
-        FSM<State, Event>* fsm_{nullptr};
-        FsmStateTable<State, Event> stateTable_;
-        FsmStateChangeTable<State, Event> changeTable_;
+        FSM* fsm_{nullptr};
     };
 
    private:
-    using Handle = std::pair<Event, std::promise<void>>;
+    // Reused through handles_, so both optional members are empty whenever a handle is free.
+    struct Handle : mpsc_hook {
+        Event event{};
+        // Set for Submit and the last event of SubmitBatch.
+        std::optional<std::promise<void>> prms;
+        // Set for snapshot requests, which carry no event.
+        std::unique_ptr<std::promise<FsmSnapshot<State, Event>>> snapshot;
+    };
+
+    Handle* NewHandle(Event event) {
+        Handle* handle = handles_.Acquire();
+        if (!handle) {
+            handle = new Handle();
+        }
+        handle->event = event;
+        return handle;
+    }
+    void FreeHandle(Handle* handle) {
+        if (!handles_.Owns(handle)) {
+            delete handle;
+            return;
+        }
+        handle->prms.reset();
+        handle->snapshot.reset();
+        handles_.Release(handle);
+    }
+
+    void Enqueue(Handle* handle) {
+        if (!queue_.enqueue(handle)) {
+            FreeHandle(handle);
+        }
+    }
+
+    // Processor only. Returns false if the FSM is being destroyed. Snapshot requests are answered
+    // while waiting; held is the event taken before the pause was noticed.
+    bool WaitWhilePaused(Handle* held, std::deque<Handle*>& backlog) {
+        if (!pause_.load()) {
+            return true;
+        }
+        std::unique_lock<std::mutex> lock(pauseMtx_);
+        while (true) {
+            pauseCv_.wait(lock, [this]() { return !pause_.load() || !ready_.load() || snapshotWaiting_ > 0; });
+            if (!ready_.load() || !pause_.load()) {
+                return ready_.load();
+            }
+            int64_t waiting = snapshotWaiting_;
+            lock.unlock();
+            ServeSnapshots(nullptr, held, backlog);
+            lock.lock();
+            if (snapshotWaiting_ == waiting) {
+                // The request is linked but hidden behind an event whose producer is between the
+                // two steps of its push, which only lasts until that producer runs again.
+                lock.unlock();
+                std::this_thread::yield();
+                lock.lock();
+            }
+        }
+    }
+
+    // Processor only. Moves the mailbox into backlog and answers request and every other snapshot
+    // request found there with the current state and all events not handled yet.
+    void ServeSnapshots(Handle* request, Handle* held, std::deque<Handle*>& backlog) {
+        while (Handle* handle = queue_.try_dequeue()) {
+            backlog.push_back(handle);
+        }
+        std::vector<Handle*> requests;
+        if (request) {
+            requests.push_back(request);
+        }
+        FsmSnapshot<State, Event> snapshot{curState_.load(), {}};
+        if (held) {
+            snapshot.pending.push_back(held->event);
+        }
+        for (auto it = backlog.begin(); it != backlog.end();) {
+            if ((*it)->snapshot) {
+                requests.push_back(*it);
+                it = backlog.erase(it);
+            } else {
+                snapshot.pending.push_back((*it)->event);
+                ++it;
+            }
+        }
+        for (Handle* handle : requests) {
+            handle->snapshot->set_value(snapshot);
+            FreeHandle(handle);
+        }
+        if (!requests.empty()) {
+            std::lock_guard<std::mutex> lock(pauseMtx_);
+            snapshotWaiting_ -= static_cast<int64_t>(requests.size());
+        }
+    }
 
    private:
+    Dispatcher dispatcher_;
     std::future<void> pooling_;
-    lock_queue<Handle> queue_;
+    FsmHandlePool<Handle> handles_;
+    mpsc_queue<Handle> queue_;
     std::atomic<State> curState_;
-    std::atomic<bool> pause_{true};
+    std::atomic<bool> pause_{false};
     std::atomic<bool> ready_{false};
-    std::atomic<bool> threadStarted_{false};
+    std::atomic<FsmTracer<State, Event>*> tracer_{nullptr};
+    std::mutex pauseMtx_;
+    std::condition_variable pauseCv_;
+    // Snapshot requests linked but not answered yet, guarded by pauseMtx_. Briefly negative when
+    // the processor answers a request before Snapshot() got to count it.
+    int64_t snapshotWaiting_{0};
+};
+
+// Runs events synchronously on the calling thread, without queue, thread or promise. Meant for
+// hot paths together with the static or dense tables. Not thread safe.
+template <typename State, typename Event, typename Dispatcher = FsmDispatcher<State, Event>>
+class FsmInline {
+   public:
+    FsmInline(StateTable<State, Event>* stateTable, StateChangeTable<State, Event>* changeTable, State initial)
+        : FsmInline(Dispatcher(stateTable, changeTable), initial) {}
+    FsmInline(Dispatcher dispatcher, State initial) : dispatcher_(std::move(dispatcher)), curState_(initial) {}
+
+    // Returns true if the event changed the state.
+    bool Dispatch(Event event) {
+        State toState;
+        if (dispatcher_.Dispatch(curState_, event, toState)) {
+            curState_ = toState;
+            return true;
+        }
+        return false;
+    }
+    State GetState() const {
+        return curState_;
+    }
+
+   private:
+    Dispatcher dispatcher_;
+    State curState_;
 };
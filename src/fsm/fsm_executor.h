@@ -0,0 +1,198 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <future>
+#include <new>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "fsm/fsm_handle_pool.h"
+#include "fsm/state_table.h"
+#include "opt/back_off.h"
+#include "queue/lock_queue.h"
+#include "queue/mpsc_queue.h"
+
+// Anything the executor can run. Run() is called by one worker at a time.
+class FsmRunnable {
+   public:
+    virtual ~FsmRunnable() = default;
+    virtual void Run() = 0;
+};
+
+// A fixed set of workers shared by any number of FsmActors. The run queue holds actors that
+// have pending events, each actor at most once, so there is no thread per state machine.
+// Mailbox handles of all actors come from one pool of HandleBlocks, so an idle actor holds none.
+class FsmExecutor {
+   public:
+    static const size_t THREAD_NUM_DEFAULT = 4;
+    static const size_t THREAD_NUM_MAX = 64;
+    static const size_t HANDLE_POOL_SIZE_DEFAULT = 4096;
+
+    // Raw storage for one mailbox handle of any actor; larger handles come from the heap.
+    struct alignas(std::max_align_t) HandleBlock {
+        unsigned char bytes[64];
+    };
+
+   public:
+    explicit FsmExecutor(size_t threadNum = THREAD_NUM_DEFAULT, size_t handlePoolSize = HANDLE_POOL_SIZE_DEFAULT)
+        : handles_(handlePoolSize) {
+        size_t num = threadNum > THREAD_NUM_MAX ? THREAD_NUM_MAX : (threadNum == 0 ? 1 : threadNum);
+        for (size_t i = 0; i < num; i++) {
+            threads_.emplace_back(WorkerTask, this);
+        }
+    }
+    // Actors must be destroyed before their executor.
+    ~FsmExecutor() {
+        runQueue_.close();
+        for (std::thread& thd : threads_) {
+            if (thd.joinable()) {
+                thd.join();
+            }
+        }
+    }
+    FsmExecutor(const FsmExecutor&) = delete;
+    FsmExecutor(FsmExecutor&&) = delete;
+    FsmExecutor& operator=(const FsmExecutor&) = delete;
+    FsmExecutor& operator=(FsmExecutor&&) = delete;
+
+    size_t Size() const {
+        return threads_.size();
+    }
+    void Schedule(FsmRunnable* runnable) {
+        runQueue_.enqueue(runnable);
+    }
+    FsmHandlePool<HandleBlock>& Handles() {
+        return handles_;
+    }
+
+   private:
+    static void WorkerTask(FsmExecutor* executor) {
+        while (std::optional<FsmRunnable*> runnable = executor->runQueue_.dequeue()) {
+            runnable.value()->Run();
+        }
+    }
+
+   private:
+    FsmHandlePool<HandleBlock> handles_;
+    lock_queue<FsmRunnable*> runQueue_;
+    std::vector<std::thread> threads_;
+};
+
+// A state machine without a thread of its own. Events go to the mailbox, and the first event
+// on an idle actor puts it on the executor's run queue. A worker then handles up to BATCH_BUDGET
+// events and requeues the actor at the tail if more are left, so busy actors cannot monopolise
+// a worker. Events of one actor are always handled serially and in submission order.
+//
+// The mailbox is an mpsc_queue of handles built in the executor's HandleBlocks, and pending_ counts
+// the events posted but not yet handled: it is non-zero exactly while the actor is scheduled or
+// running, so the producer that raises it from 0 schedules the actor and no lock is taken.
+template <typename State, typename Event, typename Dispatcher = FsmDispatcher<State, Event>>
+class FsmActor : private FsmRunnable {
+   public:
+    static const size_t BATCH_BUDGET = 64;
+
+   public:
+    FsmActor(FsmExecutor& executor, StateTable<State, Event>* stateTable,
+             StateChangeTable<State, Event>* changeTable, State initial)
+        : FsmActor(executor, Dispatcher(stateTable, changeTable), initial) {}
+    FsmActor(FsmExecutor& executor, Dispatcher dispatcher, State initial)
+        : executor_(executor), dispatcher_(std::move(dispatcher)), curState_(initial) {}
+    // Waits until the pending events have been handled.
+    ~FsmActor() override {
+        back_off<> bkoff;
+        while (pending_.load(std::memory_order_acquire) != 0) {
+            bkoff();
+        }
+    }
+    FsmActor(const FsmActor&) = delete;
+    FsmActor(FsmActor&&) = delete;
+    FsmActor& operator=(const FsmActor&) = delete;
+    FsmActor& operator=(FsmActor&&) = delete;
+
+    void Post(Event event) {
+        Enqueue(NewHandle(event));
+    }
+    std::future<void> Submit(Event event) {
+        Handle* handle = NewHandle(event);
+        std::future<void> fut = handle->prms.emplace().get_future();
+        Enqueue(handle);
+        return fut;
+    }
+    State GetState() const {
+        return curState_.load();
+    }
+
+   private:
+    struct Handle : mpsc_hook {
+        Event event{};
+        std::optional<std::promise<void>> prms;
+    };
+
+    static constexpr bool FITS_BLOCK = sizeof(Handle) <= sizeof(FsmExecutor::HandleBlock) &&
+                                       alignof(Handle) <= alignof(FsmExecutor::HandleBlock);
+
+    Handle* NewHandle(Event event) {
+        FsmExecutor::HandleBlock* block = FITS_BLOCK ? executor_.Handles().Acquire() : nullptr;
+        Handle* handle = block ? new (block) Handle() : new Handle();
+        handle->event = event;
+        return handle;
+    }
+    void FreeHandle(Handle* handle) {
+        auto* block = reinterpret_cast<FsmExecutor::HandleBlock*>(handle);
+        if (!executor_.Handles().Owns(block)) {
+            delete handle;
+            return;
+        }
+        handle->~Handle();
+        executor_.Handles().Release(block);
+    }
+
+    // Counted before it is linked, so Run() never sees more handles than pending_ holds.
+    void Enqueue(Handle* handle) {
+        bool schedule = pending_.fetch_add(1, std::memory_order_acq_rel) == 0;
+        mailbox_.enqueue(handle);
+        if (schedule) {
+            executor_.Schedule(this);
+        }
+    }
+
+    void Run() override {
+        size_t num = 0;
+        while (num < BATCH_BUDGET) {
+            // Misses a handle whose producer has counted it but not linked it yet. Once some
+            // handles are done, the next run picks it up, as the count below guarantees. With
+            // none done, requeueing would only cycle the actor through the run queue until the
+            // producer links it, so wait for the link here instead.
+            Handle* handle = mailbox_.try_dequeue();
+            if (!handle && num > 0) {
+                break;
+            }
+            for (back_off<> bkoff; !handle; handle = mailbox_.try_dequeue()) {
+                bkoff();
+            }
+            State toState;
+            if (dispatcher_.Dispatch(curState_.load(), handle->event, toState)) {
+                curState_.store(toState);
+            }
+            if (handle->prms) {
+                handle->prms->set_value();
+            }
+            FreeHandle(handle);
+            num++;
+        }
+
+        // The last access to this actor unless events are left: the destructor may be waiting.
+        if (pending_.fetch_sub(num, std::memory_order_acq_rel) != num) {
+            executor_.Schedule(this);
+        }
+    }
+
+   private:
+    FsmExecutor& executor_;
+    Dispatcher dispatcher_;
+    std::atomic<State> curState_;
+    mpsc_queue<Handle> mailbox_;
+    std::atomic<size_t> pending_{0};
+};
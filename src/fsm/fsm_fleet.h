@@ -0,0 +1,198 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "fsm/dense_table.h"
+#include "fsm/fsm_snapshot.h"
+#include "fsm/state_table.h"
+
+// A large number of identical lightweight state machines, e.g. one per connection. Each one is
+// only an entry in a contiguous state array indexed by its id; the tables are shared and built
+// once from the usual StateTable/StateChangeTable maps. There is no thread, queue or atomic per
+// machine: the owner drives the fleet from one thread (or shards ids across fleets).
+//
+// Without actions, a batch dispatch is a single pass of gathers from a flat next-state table, in
+// which a missing transition maps a state to itself, so the loop has no data-dependent branch.
+// With actions, they run in the same order as in FsmDispatcher.
+// State and Event must be contiguous enums from 0, as for the dense tables. States from NStates
+// up are rejected wherever they enter the fleet, since dispatching indexes the tables with them.
+template <typename State, typename Event, size_t NStates, size_t NEvents>
+class FsmFleet {
+   public:
+    // Returned by Add() for a rejected state.
+    static constexpr uint32_t INVALID_ID = UINT32_MAX;
+
+   public:
+    // An initial state out of range leaves the fleet empty.
+    FsmFleet(const StateTable<State, Event>* stateTable, const StateChangeTable<State, Event>* changeTable,
+             size_t size = 0, State initial = State())
+        : stateTable_(stateTable), hasActions_(HasActions(stateTable)), states_(Valid(initial) ? size : 0, initial) {
+        FsmDenseChangeTable<State, Event, NStates, NEvents> transitions(changeTable);
+        for (size_t s = 0; s < NStates; s++) {
+            for (size_t e = 0; e < NEvents; e++) {
+                State toState = static_cast<State>(s);
+                valid_[s * NEvents + e] = transitions.GetTostate(static_cast<State>(s), static_cast<Event>(e), toState);
+                next_[s * NEvents + e] = toState;
+            }
+        }
+    }
+
+    // Returns the id of the new machine, or INVALID_ID if initial is out of range.
+    uint32_t Add(State initial) {
+        if (!Valid(initial)) {
+            return INVALID_ID;
+        }
+        states_.push_back(initial);
+        return static_cast<uint32_t>(states_.size() - 1);
+    }
+    // Fails and leaves the fleet untouched if initial is out of range.
+    bool Resize(size_t size, State initial = State()) {
+        if (!Valid(initial)) {
+            return false;
+        }
+        states_.resize(size, initial);
+        return true;
+    }
+    size_t Size() const {
+        return states_.size();
+    }
+    State GetState(uint32_t id) const {
+        return states_[id];
+    }
+    // Contiguous, indexed by id.
+    const State* States() const {
+        return states_.data();
+    }
+
+    // Returns true if the event triggered a transition.
+    bool Dispatch(uint32_t id, Event event) {
+        return Dispatch(&id, &event, 1) == 1;
+    }
+
+    // Event i goes to machine ids[i], in order, so an id may appear several times. Unknown ids and
+    // events are skipped. Returns the number of events that triggered a transition.
+    size_t Dispatch(const uint32_t* ids, const Event* events, size_t count) {
+        return hasActions_ ? DispatchWithActions(ids, events, count) : DispatchStates(ids, events, count);
+    }
+
+    // The whole state array as a blob, see fsm_snapshot.h.
+    std::vector<uint8_t> Snapshot() const {
+        FsmSnapshotHeader header = Expected();
+        header.count = states_.size();
+        std::vector<uint8_t> blob(sizeof(header) + states_.size() * sizeof(State));
+        std::memcpy(blob.data(), &header, sizeof(header));
+        if (!states_.empty()) {
+            std::memcpy(blob.data() + sizeof(header), states_.data(), states_.size() * sizeof(State));
+        }
+        return blob;
+    }
+    // Replaces all states. Fails and leaves the fleet untouched if the blob was taken from a fleet
+    // with other state or event types or table sizes, or holds a state out of range.
+    bool Restore(const uint8_t* data, size_t size) {
+        FsmSnapshotHeader header;
+        if (!FsmSnapshotHeader::Check(data, size, Expected(), sizeof(State), header) ||
+            size != sizeof(header) + header.count * sizeof(State)) {
+            return false;
+        }
+        std::vector<State> states(header.count);
+        if (header.count > 0) {
+            std::memcpy(states.data(), data + sizeof(header), header.count * sizeof(State));
+        }
+        for (State state : states) {
+            if (!Valid(state)) {
+                return false;
+            }
+        }
+        states_.swap(states);
+        return true;
+    }
+    bool SaveSnapshot(const std::string& path) const {
+        std::vector<uint8_t> blob = Snapshot();
+        return FsmWriteSnapshotFile(path, blob.data(), blob.size());
+    }
+    // The file is mapped rather than read, so restoring is a single copy of the state array.
+    bool LoadSnapshot(const std::string& path) {
+        FsmMappedFile file;
+        return file.Open(path) && Restore(file.Data(), file.Size());
+    }
+
+   private:
+    static bool Valid(State state) {
+        return static_cast<size_t>(state) < NStates;
+    }
+
+    static FsmSnapshotHeader Expected() {
+        FsmSnapshotHeader header;
+        header.kind = FsmSnapshotHeader::KIND_FLEET;
+        header.stateSize = sizeof(State);
+        header.eventSize = sizeof(Event);
+        header.stateNum = static_cast<uint32_t>(NStates);
+        header.eventNum = static_cast<uint32_t>(NEvents);
+        return header;
+    }
+
+    static bool HasActions(const StateTable<State, Event>* stateTable) {
+        if (!stateTable) {
+            return false;
+        }
+        for (const auto& [state, fsmState] : *stateTable) {
+            if (fsmState.entry_ || fsmState.exit_ || fsmState.callback_) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    size_t DispatchStates(const uint32_t* ids, const Event* events, size_t count) {
+        State* states = states_.data();
+        size_t size = states_.size();
+        size_t transitions = 0;
+        for (size_t i = 0; i < count; i++) {
+            size_t id = ids[i];
+            size_t e = static_cast<size_t>(events[i]);
+            if (id >= size || e >= NEvents) {
+                continue;
+            }
+            size_t index = static_cast<size_t>(states[id]) * NEvents + e;
+            states[id] = next_[index];
+            transitions += valid_[index];
+        }
+        return transitions;
+    }
+
+    size_t DispatchWithActions(const uint32_t* ids, const Event* events, size_t count) {
+        size_t transitions = 0;
+        for (size_t i = 0; i < count; i++) {
+            size_t id = ids[i];
+            size_t e = static_cast<size_t>(events[i]);
+            if (id >= states_.size() || e >= NEvents) {
+                continue;
+            }
+            State state = states_[id];
+            size_t index = static_cast<size_t>(state) * NEvents + e;
+            stateTable_.Callback(state, events[i]);
+            if (!valid_[index]) {
+                continue;
+            }
+            State toState = next_[index];
+            stateTable_.Exit(state, events[i]);
+            stateTable_.Entry(toState, events[i]);
+            stateTable_.Callback(toState, events[i]);
+            states_[id] = toState;
+            transitions++;
+        }
+        return transitions;
+    }
+
+   private:
+    FsmDenseStateTable<State, Event, NStates> stateTable_;
+    const bool hasActions_;
+    std::array<State, NStates * NEvents> next_;
+    std::array<uint8_t, NStates * NEvents> valid_;
+    std::vector<State> states_;
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Fixed set of preallocated nodes, e.g. mailbox handles, taken and returned by any thread.
+// The free list is a stack of indices whose head carries a tag bumped on every change, so
+// Acquire() and Release() are one CAS each and a head that was popped and pushed back in
+// between cannot be mistaken for the one read before (ABA). Nodes are reused as they are:
+// callers reset what they need. When the pool is empty Acquire() returns nullptr and the
+// caller falls back to the heap; Owns() tells the two apart again on release.
+template <typename Node>
+class FsmHandlePool {
+   public:
+    explicit FsmHandlePool(size_t capacity)
+        : capacity_(capacity < EMPTY ? capacity : EMPTY - 1),
+          nodes_(new Node[capacity_]),
+          next_(new std::atomic<uint32_t>[capacity_]) {
+        for (size_t i = 0; i < capacity_; i++) {
+            next_[i].store(i + 1 < capacity_ ? static_cast<uint32_t>(i + 1) : EMPTY, std::memory_order_relaxed);
+        }
+        head_.store(capacity_ > 0 ? 0 : EMPTY, std::memory_order_release);
+    }
+    FsmHandlePool(const FsmHandlePool&) = delete;
+    FsmHandlePool& operator=(const FsmHandlePool&) = delete;
+
+    Node* Acquire() {
+        uint64_t head = head_.load(std::memory_order_acquire);
+        while (true) {
+            uint32_t index = static_cast<uint32_t>(head);
+            if (index == EMPTY) {
+                return nullptr;
+            }
+            // May be stale if another thread took index meanwhile; the tag then fails the CAS.
+            uint32_t next = next_[index].load(std::memory_order_relaxed);
+            if (head_.compare_exchange_weak(head, Pack(Tag(head) + 1, next), std::memory_order_acquire,
+                                            std::memory_order_acquire)) {
+                return &nodes_[index];
+            }
+        }
+    }
+
+    // node must come from Acquire() of this pool.
+    void Release(Node* node) {
+        uint32_t index = static_cast<uint32_t>(node - nodes_.get());
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        do {
+            next_[index].store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+        } while (!head_.compare_exchange_weak(head, Pack(Tag(head) + 1, index), std::memory_order_release,
+                                              std::memory_order_relaxed));
+    }
+
+    bool Owns(const Node* node) const {
+        uintptr_t address = reinterpret_cast<uintptr_t>(node);
+        uintptr_t first = reinterpret_cast<uintptr_t>(nodes_.get());
+        return address >= first && address < first + capacity_ * sizeof(Node);
+    }
+
+    size_t Capacity() const {
+        return capacity_;
+    }
+
+   private:
+    static constexpr uint32_t EMPTY = UINT32_MAX;
+
+    static uint64_t Tag(uint64_t head) {
+        return head >> 32;
+    }
+    static uint64_t Pack(uint64_t tag, uint32_t index) {
+        return (tag << 32) | index;
+    }
+
+   private:
+    const size_t capacity_;
+    std::unique_ptr<Node[]> nodes_;
+    std::unique_ptr<std::atomic<uint32_t>[]> next_;
+    std::atomic<uint64_t> head_{0};
+};
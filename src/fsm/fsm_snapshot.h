@@ -0,0 +1,176 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Binary snapshots of FSM and FsmFleet states. A blob is an FsmSnapshotHeader followed by raw
+// values in host byte order, so it is meant for restarting on the same machine, not as an
+// exchange format:
+//   FSM   - the current state, then `count` pending events
+//   fleet - `count` states, indexed by instance id
+// Readers check magic, version, kind and value sizes and reject anything else.
+
+struct FsmSnapshotHeader {
+    static const uint32_t MAGIC = 0x534d5346;  // "FSMS"
+    static const uint16_t VERSION = 1;
+    static const uint8_t KIND_FSM = 1;
+    static const uint8_t KIND_FLEET = 2;
+
+    uint32_t magic{MAGIC};
+    uint16_t version{VERSION};
+    uint8_t kind{0};
+    uint8_t stateSize{0};
+    uint8_t eventSize{0};
+    uint8_t reserved[3]{};
+    // Number of states and events of a fleet's tables, 0 for an FSM.
+    uint32_t stateNum{0};
+    uint32_t eventNum{0};
+    uint64_t count{0};
+
+    // Reads the header of data into header and checks it against expected, including that data
+    // is large enough for count values of valueSize.
+    static bool Check(const uint8_t* data, size_t size, const FsmSnapshotHeader& expected, size_t valueSize,
+                      FsmSnapshotHeader& header) {
+        if (!data || size < sizeof(FsmSnapshotHeader)) {
+            return false;
+        }
+        std::memcpy(&header, data, sizeof(header));
+        if (header.magic != MAGIC || header.version != VERSION || header.kind != expected.kind ||
+            header.stateSize != expected.stateSize || header.eventSize != expected.eventSize ||
+            header.stateNum != expected.stateNum || header.eventNum != expected.eventNum) {
+            return false;
+        }
+        return header.count <= (size - sizeof(FsmSnapshotHeader)) / valueSize;
+    }
+};
+static_assert(sizeof(FsmSnapshotHeader) == 32, "snapshot header layout is part of the format");
+
+// State and pending mailbox of one FSM. Restoring an FSM from it handles the pending events
+// again, in order; their completion futures are not part of the snapshot.
+template <typename State, typename Event>
+struct FsmSnapshot {
+    static_assert(std::is_trivially_copyable<State>::value && std::is_trivially_copyable<Event>::value,
+                  "states and events are stored as raw bytes");
+
+    State state{};
+    std::vector<Event> pending;
+
+    std::vector<uint8_t> Serialize() const {
+        FsmSnapshotHeader header = Expected();
+        header.count = pending.size();
+        std::vector<uint8_t> blob(sizeof(header) + sizeof(State) + pending.size() * sizeof(Event));
+        std::memcpy(blob.data(), &header, sizeof(header));
+        std::memcpy(blob.data() + sizeof(header), &state, sizeof(State));
+        if (!pending.empty()) {
+            std::memcpy(blob.data() + sizeof(header) + sizeof(State), pending.data(), pending.size() * sizeof(Event));
+        }
+        return blob;
+    }
+
+    // Leaves this snapshot untouched and returns false if the blob is not a valid FSM snapshot.
+    bool Deserialize(const uint8_t* data, size_t size) {
+        FsmSnapshotHeader header;
+        if (!FsmSnapshotHeader::Check(data, size, Expected(), sizeof(Event), header) ||
+            size != sizeof(header) + sizeof(State) + header.count * sizeof(Event)) {
+            return false;
+        }
+        std::memcpy(&state, data + sizeof(header), sizeof(State));
+        pending.resize(header.count);
+        if (header.count > 0) {
+            std::memcpy(pending.data(), data + sizeof(header) + sizeof(State), header.count * sizeof(Event));
+        }
+        return true;
+    }
+
+   private:
+    static FsmSnapshotHeader Expected() {
+        FsmSnapshotHeader header;
+        header.kind = FsmSnapshotHeader::KIND_FSM;
+        header.stateSize = sizeof(State);
+        header.eventSize = sizeof(Event);
+        return header;
+    }
+};
+
+// Writes to a temporary file next to path and renames it, so a crash never leaves a torn snapshot.
+inline bool FsmWriteSnapshotFile(const std::string& path, const uint8_t* data, size_t size) {
+    std::string tmpPath = path + ".tmp";
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    size_t written = 0;
+    while (written < size) {
+        ssize_t ret = ::write(fd, data + written, size - written);
+        if (ret <= 0) {
+            break;
+        }
+        written += static_cast<size_t>(ret);
+    }
+    bool ok = written == size && ::fsync(fd) == 0;
+    ok = ::close(fd) == 0 && ok;
+    if (!ok || std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        ::unlink(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Read-only mapping of a snapshot file, unmapped on destruction.
+class FsmMappedFile {
+   public:
+    FsmMappedFile() = default;
+    ~FsmMappedFile() {
+        Close();
+    }
+    FsmMappedFile(const FsmMappedFile&) = delete;
+    FsmMappedFile& operator=(const FsmMappedFile&) = delete;
+
+    bool Open(const std::string& path) {
+        Close();
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+            ::close(fd);
+            return false;
+        }
+        void* addr = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED) {
+            return false;
+        }
+        data_ = static_cast<const uint8_t*>(addr);
+        size_ = static_cast<size_t>(st.st_size);
+        return true;
+    }
+    void Close() {
+        if (data_) {
+            ::munmap(const_cast<uint8_t*>(data_), size_);
+            data_ = nullptr;
+            size_ = 0;
+        }
+    }
+    const uint8_t* Data() const {
+        return data_;
+    }
+    size_t Size() const {
+        return size_;
+    }
+
+   private:
+    const uint8_t* data_{nullptr};
+    size_t size_{0};
+};
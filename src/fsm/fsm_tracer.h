@@ -0,0 +1,154 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "opt/histogram.h"
+
+template <typename State, typename Event>
+struct FsmTraceRecord {
+    uint64_t timestampNs;
+    State from;
+    Event event;
+    // Equal to from if the event caused no transition.
+    State to;
+    // Time spent in the dispatcher, i.e. in the entry, exit and callback actions.
+    uint64_t actionNs;
+};
+
+// Transition trace of a single FSM. The processor is the only writer: it stores each event into
+// a fixed ring (overwriting the oldest record, never allocating) and feeds a dwell-time
+// histogram per state and an action-time histogram per (state, event). Readers may copy the
+// ring and histograms from any thread; each ring slot is guarded by a sequence number, so a
+// slot being overwritten during the copy is skipped instead of read torn.
+// Histograms are sized from stateNum x eventNum, so State and Event must be dense enums.
+template <typename State, typename Event>
+class FsmTracer {
+   public:
+    using TraceRecord = FsmTraceRecord<State, Event>;
+    static const size_t CAPACITY_DEFAULT = 1024;
+
+   public:
+    FsmTracer(size_t stateNum, size_t eventNum, size_t capacity = CAPACITY_DEFAULT)
+        : stateNum_(stateNum),
+          eventNum_(eventNum),
+          capacity_(RoundUp(capacity)),
+          slots_(new Slot[capacity_]),
+          dwell_(new log_histogram<>[stateNum]),
+          action_(new log_histogram<>[stateNum * eventNum]) {}
+    FsmTracer(const FsmTracer&) = delete;
+    FsmTracer& operator=(const FsmTracer&) = delete;
+
+    static uint64_t Now() {
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+                .count());
+    }
+
+    // Writer side: one event handled between startNs and endNs.
+    void Record(State from, Event event, State to, uint64_t startNs, uint64_t endNs) {
+        uint64_t seq = written_.load(std::memory_order_relaxed);
+        Slot& slot = slots_[seq & (capacity_ - 1)];
+        slot.seq.store(seq * 2 + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.timestampNs.store(startNs, std::memory_order_relaxed);
+        slot.fromTo.store(Pack(from, to), std::memory_order_relaxed);
+        slot.event.store(static_cast<uint64_t>(event), std::memory_order_relaxed);
+        slot.actionNs.store(endNs - startNs, std::memory_order_relaxed);
+        slot.seq.store(seq * 2 + 2, std::memory_order_release);
+        written_.store(seq + 1, std::memory_order_release);
+
+        size_t f = static_cast<size_t>(from);
+        size_t e = static_cast<size_t>(event);
+        if (f < stateNum_ && e < eventNum_) {
+            action_[f * eventNum_ + e].record(endNs - startNs);
+        }
+        // A state is entered when the transition into it is done; the state before the first
+        // recorded transition has no known entry, so it gets no dwell sample.
+        if (to != from) {
+            if (enteredNs_ != 0 && f < stateNum_) {
+                dwell_[f].record(endNs - enteredNs_);
+            }
+            enteredNs_ = endNs;
+        }
+    }
+
+    // Records still in the ring, oldest first.
+    std::vector<TraceRecord> Recent() const {
+        uint64_t end = written_.load(std::memory_order_acquire);
+        uint64_t begin = end > capacity_ ? end - capacity_ : 0;
+        std::vector<TraceRecord> records;
+        records.reserve(end - begin);
+        for (uint64_t seq = begin; seq < end; seq++) {
+            const Slot& slot = slots_[seq & (capacity_ - 1)];
+            if (slot.seq.load(std::memory_order_acquire) != seq * 2 + 2) {
+                continue;
+            }
+            uint64_t fromTo = slot.fromTo.load(std::memory_order_relaxed);
+            TraceRecord record{slot.timestampNs.load(std::memory_order_relaxed), static_cast<State>(fromTo >> 32),
+                          static_cast<Event>(slot.event.load(std::memory_order_relaxed)),
+                          static_cast<State>(fromTo & 0xFFFFFFFFULL), slot.actionNs.load(std::memory_order_relaxed)};
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) == seq * 2 + 2) {
+                records.push_back(record);
+            }
+        }
+        return records;
+    }
+
+    // Total number of events recorded, including those already overwritten in the ring.
+    uint64_t Recorded() const {
+        return written_.load(std::memory_order_acquire);
+    }
+
+    // Time between entering state and leaving it again.
+    histogram_snapshot<> DwellTime(State state) const {
+        size_t s = static_cast<size_t>(state);
+        return s < stateNum_ ? dwell_[s].snapshot() : histogram_snapshot<>();
+    }
+
+    // Time the actions triggered by event in state took.
+    histogram_snapshot<> ActionTime(State state, Event event) const {
+        size_t s = static_cast<size_t>(state);
+        size_t e = static_cast<size_t>(event);
+        return s < stateNum_ && e < eventNum_ ? action_[s * eventNum_ + e].snapshot() : histogram_snapshot<>();
+    }
+
+   private:
+    static_assert(sizeof(State) <= 4, "from and to states are packed into one 64-bit word");
+
+    struct Slot {
+        std::atomic<uint64_t> seq{0};
+        std::atomic<uint64_t> timestampNs{0};
+        std::atomic<uint64_t> fromTo{0};
+        std::atomic<uint64_t> event{0};
+        std::atomic<uint64_t> actionNs{0};
+    };
+
+    static size_t RoundUp(size_t capacity) {
+        size_t result = 1;
+        while (result < capacity) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    static uint64_t Pack(State from, State to) {
+        return (static_cast<uint64_t>(from) << 32) | static_cast<uint32_t>(to);
+    }
+
+   private:
+    const size_t stateNum_;
+    const size_t eventNum_;
+    const size_t capacity_;
+    std::unique_ptr<Slot[]> slots_;
+    std::atomic<uint64_t> written_{0};
+    std::unique_ptr<log_histogram<>[]> dwell_;
+    std::unique_ptr<log_histogram<>[]> action_;
+    // Only touched by the writer.
+    uint64_t enteredNs_{0};
+};
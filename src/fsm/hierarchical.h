@@ -0,0 +1,160 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "fsm/dense_table.h"
+#include "fsm/state_table.h"
+
+// Maps a state to its enclosing (composite) state. States without an entry are top level.
+template <typename State>
+using StateParentTable = std::map<State, State>;
+
+// Dispatcher for nested states. A transition may be declared on any enclosing state: an event
+// the current state does not handle bubbles up to its ancestors, and the first one with a
+// transition for it decides the target. Exit actions run from the current state up to the least
+// common ancestor of handler and target, entry actions from below it down to the target.
+// A target inside the handler keeps the handler active; a handler targeting itself or one of
+// its ancestors exits and re-enters that state.
+//
+// All of this is resolved once in the constructor into one flat record per (state, event), so
+// Dispatch() is a single array lookup followed by the precomputed action sequence. State and
+// Event must be contiguous enums from 0, as for the dense tables.
+template <typename State, typename Event, size_t NStates, size_t NEvents>
+class FsmHierarchicalDispatcher {
+   public:
+    FsmHierarchicalDispatcher(const StateParentTable<State>* parents, const StateTable<State, Event>* stateTable,
+                              const StateChangeTable<State, Event>* changeTable)
+        : stateTable_(stateTable) {
+        parents_.fill(NONE);
+        if (parents) {
+            for (const auto& [child, parent] : *parents) {
+                if (Index(child) < NStates && Index(parent) < NStates) {
+                    parents_[Index(child)] = parent;
+                }
+            }
+        }
+
+        FsmDenseChangeTable<State, Event, NStates, NEvents> ownTransitions(changeTable);
+        for (size_t s = 0; s < NStates; s++) {
+            for (size_t e = 0; e < NEvents; e++) {
+                records_[s * NEvents + e] = Resolve(static_cast<State>(s), static_cast<Event>(e), ownTransitions);
+            }
+        }
+    }
+
+    bool Dispatch(State state, Event event, State& toState) {
+        stateTable_.Callback(state, event);
+        if (Index(state) >= NStates || Index(event) >= NEvents) {
+            return false;
+        }
+        const Record& record = records_[Index(state) * NEvents + Index(event)];
+        if (record.target == NONE) {
+            return false;
+        }
+        for (uint32_t i = 0; i < record.exitCount; i++) {
+            stateTable_.Exit(path_[record.exitBegin + i], event);
+        }
+        for (uint32_t i = 0; i < record.entryCount; i++) {
+            stateTable_.Entry(path_[record.entryBegin + i], event);
+        }
+        stateTable_.Callback(record.target, event);
+        toState = record.target;
+        return true;
+    }
+
+    // Resolved target of event in state, after bubbling.
+    bool GetTostate(State state, Event event, State& toState) const {
+        if (Index(state) >= NStates || Index(event) >= NEvents) {
+            return false;
+        }
+        State target = records_[Index(state) * NEvents + Index(event)].target;
+        if (target == NONE) {
+            return false;
+        }
+        toState = target;
+        return true;
+    }
+
+   private:
+    struct Record {
+        State target{NONE};
+        uint32_t exitBegin{0};
+        uint32_t exitCount{0};
+        uint32_t entryBegin{0};
+        uint32_t entryCount{0};
+    };
+
+    static constexpr size_t Index(State state) {
+        return static_cast<size_t>(state);
+    }
+    static constexpr size_t Index(Event event) {
+        return static_cast<size_t>(event);
+    }
+
+    // state followed by its ancestors, bounded so that a cyclic parent table cannot loop.
+    std::vector<State> Ancestors(State state) const {
+        std::vector<State> chain;
+        for (State cur = state; cur != NONE && chain.size() < NStates; cur = parents_[Index(cur)]) {
+            chain.push_back(cur);
+        }
+        return chain;
+    }
+
+    Record Resolve(State state, Event event, const FsmDenseChangeTable<State, Event, NStates, NEvents>& own) {
+        Record record;
+        State handler = NONE;
+        State target = NONE;
+        for (State ancestor : Ancestors(state)) {
+            if (own.GetTostate(ancestor, event, target)) {
+                handler = ancestor;
+                break;
+            }
+        }
+        if (handler == NONE) {
+            return record;
+        }
+
+        std::vector<State> targetChain = Ancestors(target);
+        State lca = NONE;
+        for (State ancestor : Ancestors(handler)) {
+            if (std::find(targetChain.begin(), targetChain.end(), ancestor) != targetChain.end()) {
+                lca = ancestor;
+                break;
+            }
+        }
+        if (lca == target) {
+            lca = parents_[Index(target)];
+        }
+
+        record.target = target;
+        record.exitBegin = static_cast<uint32_t>(path_.size());
+        for (State cur = state; cur != lca && cur != NONE; cur = parents_[Index(cur)]) {
+            path_.push_back(cur);
+            record.exitCount++;
+        }
+        record.entryBegin = static_cast<uint32_t>(path_.size());
+        for (State t : targetChain) {
+            if (t == lca) {
+                break;
+            }
+            path_.push_back(t);
+            record.entryCount++;
+        }
+        // Entry runs outermost first.
+        std::reverse(path_.begin() + record.entryBegin, path_.end());
+        return record;
+    }
+
+   private:
+    static constexpr State NONE = static_cast<State>(NStates);
+    FsmDenseStateTable<State, Event, NStates> stateTable_;
+    std::array<State, NStates> parents_;
+    std::array<Record, NStates * NEvents> records_;
+    // Exit and entry sequences of all records, back to back.
+    std::vector<State> path_;
+};
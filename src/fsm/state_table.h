@@ -2,6 +2,7 @@
 
 #include <functional>
 #include <map>
+#include <utility>
 
 template <typename Event>
 using Action = std::function<void(Event event)>;
@@ -24,27 +25,28 @@ class FsmStateTable {
    public:
     explicit FsmStateTable(StateTable<State, Event>* table = nullptr) : table_(table) {}
     void Entry(State state, Event event) {
-        if (Valid(state)) {
-            table_->find(state)->second.entry_(event);
+        if (FsmState<State, Event>* fsmState = Find(state)) {
+            fsmState->entry_(event);
         }
     }
     void Exit(State state, Event event) {
-        if (Valid(state)) {
-            table_->find(state)->second.exit_(event);
+        if (FsmState<State, Event>* fsmState = Find(state)) {
+            fsmState->exit_(event);
         }
     }
     void Callback(State state, Event event) {
-        if (Valid(state)) {
-            table_->find(state)->second.callback_(event);
+        if (FsmState<State, Event>* fsmState = Find(state)) {
+            fsmState->callback_(event);
         }
     }
 
    private:
-    bool Valid(State state) {
-        if (table_ && table_->find(state) != table_->end()) {
-            return true;
+    FsmState<State, Event>* Find(State state) {
+        if (!table_) {
+            return nullptr;
         }
-        return false;
+        auto it = table_->find(state);
+        return it != table_->end() ? &it->second : nullptr;
     }
 
    private:
@@ -62,22 +64,60 @@ class FsmStateChangeTable {
    public:
     explicit FsmStateChangeTable(StateChangeTable<State, Event>* table = nullptr) : table_(table) {}
     bool Valid(State state, Event event) {
-        if (table_ && table_->find(state) != table_->end()) {
-            const std::map<Event, State>& eventTable = (*table_)[state];
-            if (eventTable.find(event) != eventTable.end()) {
-                return true;
-            }
-        }
-        return false;
+        State toState;
+        return GetTostate(state, event, toState);
     }
     bool GetTostate(State state, Event event, State& toState) {
-        if (Valid(state, event)) {
-            toState = (*table_)[state][event];
-            return true;
+        if (!table_) {
+            return false;
+        }
+        auto stateIt = table_->find(state);
+        if (stateIt == table_->end()) {
+            return false;
+        }
+        auto eventIt = stateIt->second.find(event);
+        if (eventIt == stateIt->second.end()) {
+            return false;
         }
-        return false;
+        toState = eventIt->second;
+        return true;
     }
 
    private:
     StateChangeTable<State, Event>* table_{nullptr};
 };
+
+// Runs one event against a pair of table policies: the current state's callback, then on a
+// transition exit of the old state, entry and callback of the new one. Any types with the
+// Entry/Exit/Callback and GetTostate members of the tables above can be plugged in.
+template <typename State, typename Event, typename StateTablePolicy = FsmStateTable<State, Event>,
+          typename ChangeTablePolicy = FsmStateChangeTable<State, Event>>
+class FsmDispatcher {
+   public:
+    FsmDispatcher(StateTablePolicy stateTable, ChangeTablePolicy changeTable)
+        : stateTable_(std::move(stateTable)), changeTable_(std::move(changeTable)) {}
+    FsmDispatcher(StateTable<State, Event>* stateTable, StateChangeTable<State, Event>* changeTable)
+        : stateTable_(stateTable), changeTable_(changeTable) {}
+
+    // Returns true and sets toState if the event triggers a transition.
+    bool Dispatch(State state, Event event, State& toState) {
+        stateTable_.Callback(state, event);
+        if (!changeTable_.GetTostate(state, event, toState)) {
+            return false;
+        }
+        stateTable_.Exit(state, event);
+        stateTable_.Entry(toState, event);
+        stateTable_.Callback(toState, event);
+        return true;
+    }
+
+   private:
+    StateTablePolicy stateTable_;
+    ChangeTablePolicy changeTable_;
+};
+
+template <typename State, typename Event, typename StateTablePolicy, typename ChangeTablePolicy>
+FsmDispatcher<State, Event, StateTablePolicy, ChangeTablePolicy> MakeFsmDispatcher(StateTablePolicy stateTable,
+                                                                                   ChangeTablePolicy changeTable) {
+    return {std::move(stateTable), std::move(changeTable)};
+}
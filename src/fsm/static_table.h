@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Tables whose actions and transitions are part of the type. Lookups are folded over the
+// compile-time list into a compare chain the compiler can turn into a switch, and the action
+// functors are called directly, so they can be inlined into FsmDispatcher::Dispatch.
+
+struct FsmNoAction {
+    template <typename Event>
+    constexpr void operator()(Event) const noexcept {}
+};
+
+template <auto S, typename Entry = FsmNoAction, typename Exit = FsmNoAction, typename Callback = FsmNoAction>
+struct FsmStaticState {
+    static constexpr auto STATE = S;
+    Entry entry_;
+    Exit exit_;
+    Callback callback_;
+};
+
+template <auto S, typename Entry = FsmNoAction, typename Exit = FsmNoAction, typename Callback = FsmNoAction>
+constexpr FsmStaticState<S, Entry, Exit, Callback> MakeFsmState(Entry entry = Entry(), Exit exit = Exit(),
+                                                                Callback callback = Callback()) {
+    return {std::move(entry), std::move(exit), std::move(callback)};
+}
+
+// States without an entry in the table have no actions.
+template <typename... States>
+class FsmStaticStateTable {
+   public:
+    constexpr explicit FsmStaticStateTable(States... states) : states_(std::move(states)...) {}
+
+    template <typename State, typename Event>
+    void Entry(State state, Event event) {
+        Invoke(state, event, [](auto& fsmState, Event e) { fsmState.entry_(e); },
+               std::index_sequence_for<States...>());
+    }
+    template <typename State, typename Event>
+    void Exit(State state, Event event) {
+        Invoke(state, event, [](auto& fsmState, Event e) { fsmState.exit_(e); }, std::index_sequence_for<States...>());
+    }
+    template <typename State, typename Event>
+    void Callback(State state, Event event) {
+        Invoke(state, event, [](auto& fsmState, Event e) { fsmState.callback_(e); },
+               std::index_sequence_for<States...>());
+    }
+
+   private:
+    template <typename State, typename Event, typename Action, size_t... I>
+    void Invoke(State state, Event event, Action action, std::index_sequence<I...>) {
+        (void)((state == std::tuple_element_t<I, std::tuple<States...>>::STATE
+                    ? (action(std::get<I>(states_), event), true)
+                    : false) ||
+               ...);
+    }
+
+   private:
+    std::tuple<States...> states_;
+};
+
+template <auto From, auto On, auto To>
+struct FsmStaticTransition {
+    static constexpr auto FROM = From;
+    static constexpr auto EVENT = On;
+    static constexpr auto TO = To;
+};
+
+// The first matching transition wins.
+template <typename... Transitions>
+class FsmStaticChangeTable {
+   public:
+    template <typename State, typename Event>
+    constexpr bool Valid(State state, Event event) const {
+        State toState = state;
+        return GetTostate(state, event, toState);
+    }
+    template <typename State, typename Event>
+    constexpr bool GetTostate(State state, Event event, State& toState) const {
+        return ((state == Transitions::FROM && event == Transitions::EVENT ? (toState = Transitions::TO, true)
+                                                                           : false) ||
+                ...);
+    }
+};
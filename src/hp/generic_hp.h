@@ -180,8 +180,9 @@ public:
 
     static void construct(size_t hazard_ptr_count = smr::kDefaultHazardPtrCount,
                           size_t max_thread_count = smr::kDefaultMaxThreadCount,
-                          size_t max_retired_ptr_count = smr::kDefaultMaxRetiredPtrCount) {
-        smr::construct(hazard_ptr_count, max_thread_count, max_retired_ptr_count);
+                          size_t max_retired_ptr_count = smr::kDefaultMaxRetiredPtrCount,
+                          scan_type type = smr::kDefaultScanType) {
+        smr::construct(hazard_ptr_count, max_thread_count, max_retired_ptr_count, type);
     }
 
     static void destruct() { smr::destruct(); }
@@ -234,6 +235,10 @@ public:
     static size_t retired_array_capacity() {
         return smr::instance().max_retired_ptr_count();
     }
+
+    static scan_type get_scan_type() {
+        return smr::instance().get_scan_type();
+    }
 };
 
 }  // namespace hp
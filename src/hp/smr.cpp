@@ -8,9 +8,10 @@ namespace hp {
 
 smr* smr::instance_ = nullptr;
 
-void smr::construct(size_t hazard_ptr_count, size_t max_thread_count, size_t max_retired_ptr_count) {
+void smr::construct(size_t hazard_ptr_count, size_t max_thread_count, size_t max_retired_ptr_count,
+                    scan_type type) {
     if (instance_) return;
-    instance_ = new smr(hazard_ptr_count, max_thread_count, max_retired_ptr_count);
+    instance_ = new smr(hazard_ptr_count, max_thread_count, max_retired_ptr_count, type);
 }
 
 void smr::destruct() {
@@ -18,11 +19,12 @@ void smr::destruct() {
     instance_ = nullptr;
 }
 
-smr::smr(size_t hazard_ptr_count, size_t max_thread_count, size_t max_retired_ptr_count)
+smr::smr(size_t hazard_ptr_count, size_t max_thread_count, size_t max_retired_ptr_count, scan_type type)
     : thread_list_(nullptr),
       hazard_ptr_count_(hazard_ptr_count),
       max_thread_count_(max_thread_count),
-      max_retired_ptr_count_(max_retired_ptr_count) {}
+      max_retired_ptr_count_(max_retired_ptr_count),
+      scan_type_(type) {}
 
 smr::~smr() {
     thread_record* rec = thread_list_.load(std::memory_order_acquire);
@@ -221,7 +223,11 @@ void smr::inplace_scan(thread_data* rec) {
 }
 
 void smr::scan(thread_data* rec) {
-    inplace_scan(rec);
+    if (scan_type_ == scan_type::classic) {
+        classic_scan(rec);
+    } else {
+        inplace_scan(rec);
+    }
 }
 
 void smr::help_scan(thread_data* this_rec) {
@@ -6,11 +6,16 @@
 namespace detail {
 namespace hp {
 
+// classic: 收集所有 hazard 指针并排序，再对每个 retired 指针二分查找
+// inplace: 对每个 retired 指针线性遍历所有 hazard 指针，不分配内存
+enum class scan_type { classic, inplace };
+
 class smr {
 public:
     static constexpr size_t kDefaultHazardPtrCount = 8;
     static constexpr size_t kDefaultMaxThreadCount = 128;
     static constexpr size_t kDefaultMaxRetiredPtrCount = 100;
+    static constexpr scan_type kDefaultScanType = scan_type::inplace;
 
     static smr& instance() {
         if (instance_ == nullptr) {
@@ -25,13 +30,15 @@ public:
 
     static void construct(size_t hazard_ptr_count = kDefaultHazardPtrCount,
                           size_t max_thread_count = kDefaultMaxThreadCount,
-                          size_t max_retired_ptr_count = kDefaultMaxRetiredPtrCount);
+                          size_t max_retired_ptr_count = kDefaultMaxRetiredPtrCount,
+                          scan_type type = kDefaultScanType);
 
     static void destruct();
 
     size_t hazard_ptr_count() const noexcept { return hazard_ptr_count_; }
     size_t max_thread_count() const noexcept { return max_thread_count_; }
     size_t max_retired_ptr_count() const noexcept { return max_retired_ptr_count_; }
+    scan_type get_scan_type() const noexcept { return scan_type_; }
 
     void scan(thread_data* rec);
     void help_scan(thread_data* this_rec);
@@ -39,7 +46,7 @@ public:
     void free_thread_data(thread_data* rec, bool call_help_scan);
 
 private:
-    smr(size_t hazard_ptr_count, size_t max_thread_count, size_t max_retired_ptr_count);
+    smr(size_t hazard_ptr_count, size_t max_thread_count, size_t max_retired_ptr_count, scan_type type);
     ~smr();
 
     smr(const smr&) = delete;
@@ -64,6 +71,7 @@ private:
     size_t const hazard_ptr_count_;
     size_t const max_thread_count_;
     size_t const max_retired_ptr_count_;
+    scan_type const scan_type_;
 };
 
 }  // namespace hp
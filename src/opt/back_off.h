@@ -21,6 +21,11 @@ class back_off {
         }
     }
 
+    // True once the spin budget is used up and further calls only yield.
+    bool exhausted() const noexcept {
+        return cur_spin_ > Traits::upper_bound;
+    }
+
    private:
     void spin() noexcept {
 #if defined(__x86_64__) || defined(__i386__)
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+// Eventcount: lets a consumer sleep on an arbitrary lock-free condition without lost wakeups,
+// while producers pay only a fence and a load when nobody is sleeping.
+//
+// Consumer:                                  Producer:
+//   if (ready()) return;                       publish();
+//   auto key = ec.prepare_wait();              ec.notify_one();
+//   if (ready()) { ec.cancel_wait(); return; }
+//   ec.wait(key);
+//
+// The state word keeps the number of announced waiters in the low half and a wakeup epoch in
+// the high half. A waiter sleeps until the epoch moves past the one it saw in prepare_wait().
+class event_count {
+   public:
+    class key {
+        friend class event_count;
+        explicit key(uint32_t epoch) : epoch_(epoch) {}
+        uint32_t epoch_;
+    };
+
+   public:
+    event_count() = default;
+    event_count(const event_count&) = delete;
+    event_count& operator=(const event_count&) = delete;
+
+    key prepare_wait() noexcept {
+        uint64_t prev = state_.fetch_add(WAITER_INC, std::memory_order_seq_cst);
+        return key(static_cast<uint32_t>(prev >> EPOCH_SHIFT));
+    }
+
+    void cancel_wait() noexcept {
+        state_.fetch_sub(WAITER_INC, std::memory_order_seq_cst);
+    }
+
+    void wait(key k) {
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            cv_.wait(lock, [this, k] { return epoch() != k.epoch_; });
+        }
+        state_.fetch_sub(WAITER_INC, std::memory_order_seq_cst);
+    }
+
+    void notify_one() {
+        notify(false);
+    }
+
+    void notify_all() {
+        notify(true);
+    }
+
+    bool has_waiters() const noexcept {
+        return (state_.load(std::memory_order_acquire) & WAITER_MASK) != 0;
+    }
+
+   private:
+    void notify(bool all) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if ((state_.load(std::memory_order_seq_cst) & WAITER_MASK) == 0) {
+            return;
+        }
+        state_.fetch_add(EPOCH_INC, std::memory_order_seq_cst);
+        {
+            // A waiter checks the epoch under mtx_, so it is either still before its check or already asleep.
+            std::lock_guard<std::mutex> lock(mtx_);
+        }
+        if (all) {
+            cv_.notify_all();
+        } else {
+            cv_.notify_one();
+        }
+    }
+
+    uint32_t epoch() const noexcept {
+        return static_cast<uint32_t>(state_.load(std::memory_order_acquire) >> EPOCH_SHIFT);
+    }
+
+   private:
+    static constexpr uint64_t WAITER_INC = 1;
+    static constexpr uint64_t WAITER_MASK = 0xFFFFFFFFULL;
+    static constexpr uint32_t EPOCH_SHIFT = 32;
+    static constexpr uint64_t EPOCH_INC = 1ULL << EPOCH_SHIFT;
+
+    std::atomic<uint64_t> state_{0};
+    std::mutex mtx_;
+    std::condition_variable cv_;
+};
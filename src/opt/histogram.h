@@ -0,0 +1,125 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Log-linear bucketing in the style of HdrHistogram: values below 2^SubBucketBits get a bucket
+// each, larger values are split by their most significant bit into power-of-two ranges and each
+// range into 2^SubBucketBits linear sub-buckets. SubBucketBits = 0 gives plain log2 buckets.
+template <size_t SubBucketBits = 0>
+struct histogram_layout {
+    static constexpr size_t sub_bucket_count = size_t{1} << SubBucketBits;
+    static constexpr size_t bucket_count = (64 - SubBucketBits + 1) * sub_bucket_count;
+
+    static size_t index(uint64_t value) noexcept {
+        if (value < sub_bucket_count) {
+            return static_cast<size_t>(value);
+        }
+        size_t msb = 63 - static_cast<size_t>(__builtin_clzll(value));
+        size_t shift = msb - SubBucketBits;
+        return ((shift + 1) << SubBucketBits) + static_cast<size_t>((value >> shift) & (sub_bucket_count - 1));
+    }
+
+    // Largest value that maps to bucket i.
+    static uint64_t upper_bound(size_t i) noexcept {
+        if (i < sub_bucket_count) {
+            return i;
+        }
+        size_t shift = (i >> SubBucketBits) - 1;
+        uint64_t base = (uint64_t{1} << SubBucketBits) | (i & (sub_bucket_count - 1));
+        return ((base + 1) << shift) - 1;
+    }
+};
+
+// Plain counts copied out of a log_histogram; cheap to merge and query.
+template <size_t SubBucketBits = 0>
+struct histogram_snapshot {
+    using layout = histogram_layout<SubBucketBits>;
+
+    std::array<uint64_t, layout::bucket_count> buckets{};
+    uint64_t count{0};
+    uint64_t sum{0};
+    uint64_t max{0};
+
+    void merge(const histogram_snapshot& other) noexcept {
+        for (size_t i = 0; i < buckets.size(); i++) {
+            buckets[i] += other.buckets[i];
+        }
+        count += other.count;
+        sum += other.sum;
+        max = other.max > max ? other.max : max;
+    }
+
+    double mean() const noexcept {
+        return count == 0 ? 0.0 : static_cast<double>(sum) / static_cast<double>(count);
+    }
+
+    // Upper bound of the bucket holding the p-th percentile (p in [0, 100]), clamped to max.
+    uint64_t percentile(double p) const noexcept {
+        if (count == 0) {
+            return 0;
+        }
+        uint64_t rank = static_cast<uint64_t>(p / 100.0 * static_cast<double>(count) + 0.5);
+        rank = rank == 0 ? 1 : rank;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < buckets.size(); i++) {
+            seen += buckets[i];
+            if (seen >= rank) {
+                uint64_t bound = layout::upper_bound(i);
+                return bound < max ? bound : max;
+            }
+        }
+        return max;
+    }
+};
+
+// Concurrent histogram of non-negative integer samples (typically nanoseconds).
+// Recording is a few relaxed atomic adds; give each writer its own instance to avoid sharing.
+template <size_t SubBucketBits = 0>
+class log_histogram {
+   public:
+    using layout = histogram_layout<SubBucketBits>;
+    using snapshot_type = histogram_snapshot<SubBucketBits>;
+
+   public:
+    log_histogram() = default;
+    log_histogram(const log_histogram&) = delete;
+    log_histogram& operator=(const log_histogram&) = delete;
+
+    void record(uint64_t value) noexcept {
+        buckets_[layout::index(value)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+        uint64_t cur = max_.load(std::memory_order_relaxed);
+        while (value > cur && !max_.compare_exchange_weak(cur, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    snapshot_type snapshot() const noexcept {
+        snapshot_type snap;
+        for (size_t i = 0; i < snap.buckets.size(); i++) {
+            snap.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+        }
+        snap.count = count_.load(std::memory_order_relaxed);
+        snap.sum = sum_.load(std::memory_order_relaxed);
+        snap.max = max_.load(std::memory_order_relaxed);
+        return snap;
+    }
+
+    void reset() noexcept {
+        for (auto& bucket : buckets_) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        count_.store(0, std::memory_order_relaxed);
+        sum_.store(0, std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+   private:
+    std::array<std::atomic<uint64_t>, layout::bucket_count> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
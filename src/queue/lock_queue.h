@@ -53,6 +53,23 @@ class lock_queue {
         return enqueue_impl([&val](std::queue<value_type>& queue) { queue.push(std::move(val)); });
     }
 
+    // Push [first, last) under a single lock acquisition. Pass move iterators to move the items.
+    template <typename InputIt>
+    bool enqueue_bulk(InputIt first, InputIt last) {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            if (closed_) {
+                return false;
+            }
+
+            for (; first != last; ++first) {
+                queue_.push(*first);
+            }
+        }
+        cond_.notify_all();
+        return true;
+    }
+
     template <typename... Args>
     bool emplace(Args&&... args) {
         return enqueue_impl([&args...](std::queue<value_type>& queue) { queue.emplace(std::forward<Args>(args)...); });
@@ -95,6 +112,23 @@ class lock_queue {
         return dequeue_with(f) ? std::move(result) : std::nullopt;
     }
 
+    // Block until the queue is non-empty or closed, then move up to max items to out under a
+    // single lock acquisition. Items queued before close() are still handed out, so 0 is only
+    // returned once the queue is closed and empty.
+    template <typename OutputIt>
+    size_t dequeue_bulk(OutputIt out, size_t max) {
+        std::unique_lock<std::mutex> lock(mtx_);
+        cond_.wait(lock, [this]() { return !queue_.empty() || closed_; });
+
+        size_t count = 0;
+        for (; count < max && !queue_.empty(); ++count) {
+            *out = std::move(queue_.front());
+            ++out;
+            queue_.pop();
+        }
+        return count;
+    }
+
     void close() {
         {
             std::lock_guard<std::mutex> lock(mtx_);
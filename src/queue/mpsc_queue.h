@@ -0,0 +1,156 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+
+#include "opt/cache_line.h"
+#include "opt/event_count.h"
+
+// Link embedded in every element of an mpsc_queue.
+struct mpsc_hook {
+    std::atomic<mpsc_hook*> next_{nullptr};
+};
+
+// Vyukov's intrusive multi-producer single-consumer queue. Elements derive from mpsc_hook and
+// are owned by the caller; the queue never allocates. enqueue() is one atomic exchange plus a
+// store, and only touches the event_count when the consumer has announced that it sleeps.
+//
+// A push is visible to the consumer once its second step (linking prev->next_) is done, so
+// try_dequeue() may briefly miss an element whose producer was preempted between the two steps.
+// The blocking dequeue() is not affected: that producer notifies after linking.
+template <typename T>
+class mpsc_queue {
+   public:
+    using value_type = T*;
+
+   public:
+    mpsc_queue() : head_(&stub_), tail_(&stub_) {}
+    mpsc_queue(const mpsc_queue&) = delete;
+    mpsc_queue& operator=(const mpsc_queue&) = delete;
+    mpsc_queue(mpsc_queue&&) = delete;
+    mpsc_queue& operator=(mpsc_queue&&) = delete;
+
+    // Any thread. Returns false if the queue is closed, node is not linked then.
+    bool enqueue(T* node) {
+        if (closed_.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        push(node);
+        park_.notify_one();
+        return true;
+    }
+
+    // Any thread. Links nodes[0..count) in order with a single exchange on the shared head.
+    bool enqueue_bulk(T* const* nodes, size_t count) {
+        if (closed_.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        if (count == 0) {
+            return true;
+        }
+        for (size_t i = 0; i + 1 < count; i++) {
+            nodes[i]->next_.store(nodes[i + 1], std::memory_order_relaxed);
+        }
+        nodes[count - 1]->next_.store(nullptr, std::memory_order_relaxed);
+        mpsc_hook* prev = head_.exchange(nodes[count - 1], std::memory_order_acq_rel);
+        prev->next_.store(nodes[0], std::memory_order_release);
+        park_.notify_one();
+        return true;
+    }
+
+    // Consumer only.
+    T* try_dequeue() {
+        mpsc_hook* tail = tail_;
+        mpsc_hook* next = tail->next_.load(std::memory_order_acquire);
+        if (tail == &stub_) {
+            if (next == nullptr) {
+                return nullptr;
+            }
+            tail_ = next;
+            tail = next;
+            next = next->next_.load(std::memory_order_acquire);
+        }
+        if (next != nullptr) {
+            tail_ = next;
+            return static_cast<T*>(tail);
+        }
+        if (tail != head_.load(std::memory_order_acquire)) {
+            return nullptr;  // A producer is between exchange and link.
+        }
+        // tail is the last element, put the stub behind it so that it can be handed out.
+        push(&stub_);
+        next = tail->next_.load(std::memory_order_acquire);
+        if (next != nullptr) {
+            tail_ = next;
+            return static_cast<T*>(tail);
+        }
+        return nullptr;
+    }
+
+    // Consumer only. Parks until an element arrives; returns nullptr once closed and drained.
+    // Drained means every element whose enqueue() returned true before close() was handed out,
+    // including those whose producer is still linking them.
+    T* dequeue() {
+        while (true) {
+            if (T* node = try_dequeue()) {
+                return node;
+            }
+            event_count::key key = park_.prepare_wait();
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (T* node = try_dequeue()) {
+                park_.cancel_wait();
+                return node;
+            }
+            if (closed_.load(std::memory_order_acquire)) {
+                park_.cancel_wait();
+                return drain();
+            }
+            park_.wait(key);
+        }
+    }
+
+    // Consumer only, exact when no enqueue is in progress.
+    bool empty() const {
+        return tail_ == &stub_ && stub_.next_.load(std::memory_order_acquire) == nullptr;
+    }
+
+    // An enqueue() overlapping close() may succeed and still be missed by the drain if it had not
+    // reached its exchange yet, so stop producers first when every element matters.
+    void close() {
+        closed_.store(true, std::memory_order_release);
+        park_.notify_all();
+    }
+
+    bool is_closed() const {
+        return closed_.load(std::memory_order_acquire);
+    }
+
+   private:
+    // Consumer only, once closed. try_dequeue() returning nullptr is final only when head and
+    // tail meet (on the stub); otherwise a producer is between exchange and link, so wait for it.
+    T* drain() {
+        while (true) {
+            if (T* node = try_dequeue()) {
+                return node;
+            }
+            if (head_.load(std::memory_order_acquire) == tail_) {
+                return nullptr;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    void push(mpsc_hook* node) {
+        node->next_.store(nullptr, std::memory_order_relaxed);
+        mpsc_hook* prev = head_.exchange(node, std::memory_order_acq_rel);
+        prev->next_.store(node, std::memory_order_release);
+    }
+
+   private:
+    alignas(CACHE_LINE_SIZE) std::atomic<mpsc_hook*> head_;
+    alignas(CACHE_LINE_SIZE) mpsc_hook* tail_;
+    mpsc_hook stub_;
+    std::atomic<bool> closed_{false};
+    event_count park_;
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+enum class TaskStatus : uint8_t { COMPLETED, CANCELLED, EXPIRED };
+
+// Read side of a cancellation flag. A default constructed token is never cancelled
+// and costs nothing to check.
+class CancellationToken {
+   public:
+    CancellationToken() = default;
+
+    bool Cancelled() const {
+        return state_ && state_->load(std::memory_order_acquire);
+    }
+
+   private:
+    friend class CancellationSource;
+    explicit CancellationToken(std::shared_ptr<std::atomic<bool>> state) : state_(std::move(state)) {}
+
+   private:
+    std::shared_ptr<std::atomic<bool>> state_;
+};
+
+// Owner side: every token handed out by Token() observes Cancel().
+class CancellationSource {
+   public:
+    CancellationSource() : state_(std::make_shared<std::atomic<bool>>(false)) {}
+
+    CancellationToken Token() const {
+        return CancellationToken(state_);
+    }
+    void Cancel() {
+        state_->store(true, std::memory_order_release);
+    }
+    bool Cancelled() const {
+        return state_->load(std::memory_order_acquire);
+    }
+
+   private:
+    std::shared_ptr<std::atomic<bool>> state_;
+};
+
+// Checked by the worker right after a task is dequeued: a cancelled or expired task is dropped
+// without running and its future completes with the corresponding status.
+struct TaskControl {
+    CancellationToken token;
+    std::optional<std::chrono::steady_clock::time_point> deadline;
+
+    TaskStatus Check() const {
+        if (token.Cancelled()) {
+            return TaskStatus::CANCELLED;
+        }
+        if (deadline && std::chrono::steady_clock::now() > *deadline) {
+            return TaskStatus::EXPIRED;
+        }
+        return TaskStatus::COMPLETED;
+    }
+};
+
+template <typename R>
+struct TaskResult {
+    TaskStatus status{TaskStatus::COMPLETED};
+    // Always set when status is COMPLETED.
+    std::optional<R> value;
+};
+
+template <>
+struct TaskResult<void> {
+    TaskStatus status{TaskStatus::COMPLETED};
+};
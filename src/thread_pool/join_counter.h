@@ -0,0 +1,41 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+// Counts outstanding work of a fork/join region.
+// Workers call Done() as pieces finish, the owner blocks in Wait() until the count drops to zero.
+// Wait() always returns through the mutex, so the counter may be destroyed right after it returns.
+class JoinCounter {
+   public:
+    explicit JoinCounter(size_t count) : pending_(count), done_(count == 0) {}
+    JoinCounter(const JoinCounter&) = delete;
+    JoinCounter& operator=(const JoinCounter&) = delete;
+    JoinCounter(JoinCounter&&) = delete;
+    JoinCounter& operator=(JoinCounter&&) = delete;
+
+    void Done(size_t count = 1) {
+        if (pending_.fetch_sub(count, std::memory_order_acq_rel) == count) {
+            std::lock_guard<std::mutex> lock(mtx_);
+            done_ = true;
+            cv_.notify_all();
+        }
+    }
+
+    bool Finished() const {
+        return pending_.load(std::memory_order_acquire) == 0;
+    }
+
+    void Wait() {
+        std::unique_lock<std::mutex> lock(mtx_);
+        cv_.wait(lock, [this] { return done_; });
+    }
+
+   private:
+    std::atomic<size_t> pending_;
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    bool done_{false};
+};
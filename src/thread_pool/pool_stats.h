@@ -0,0 +1,117 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "opt/cache_line.h"
+#include "opt/histogram.h"
+
+// Per-worker counters, read by snapshot, written only by their worker (the last slot is shared
+// by non-worker threads that run tasks while helping, e.g. in ThreadPool::Join). Each slot sits on its own
+// cache lines so that recording never bounces a line between workers.
+struct alignas(CACHE_LINE_SIZE) WorkerStats {
+    std::atomic<uint64_t> tasks{0};
+    std::atomic<uint64_t> steals{0};
+    std::atomic<uint64_t> busyNs{0};
+    std::atomic<uint64_t> idleNs{0};
+    log_histogram<> queueWaitNs;
+    log_histogram<> runNs;
+};
+
+struct WorkerStatsSnapshot {
+    uint64_t tasks{0};
+    // Part of tasks taken from the shared queue while helping, i.e. while blocked in
+    // ThreadPool::Join (ParallelFor, ParallelReduce) rather than from the worker loop. The
+    // pools have no per-worker queues, so this is the only form of stealing; always 0 for
+    // ThreadPool<Data>, which has no Join.
+    uint64_t steals{0};
+    uint64_t busyNs{0};
+    uint64_t idleNs{0};
+};
+
+struct PoolStats {
+    // One entry per worker followed by one entry for helping threads.
+    std::vector<WorkerStatsSnapshot> workers;
+    histogram_snapshot<> queueWaitNs;
+    histogram_snapshot<> runNs;
+    size_t queueDepth{0};
+};
+
+// Optional instrumentation shared by both thread pools. While disabled every hook costs one
+// relaxed load; Now() returns 0 in that case and 0 timestamps are ignored by the Record calls.
+class PoolStatsCollector {
+   public:
+    explicit PoolStatsCollector(size_t workerNum) : slotNum_(workerNum + 1), slots_(new WorkerStats[slotNum_]) {}
+
+    void Enable(bool enable) {
+        enabled_.store(enable, std::memory_order_relaxed);
+    }
+    bool Enabled() const {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+    size_t HelperSlot() const {
+        return slotNum_ - 1;
+    }
+
+    uint64_t Now() const {
+        if (!Enabled()) {
+            return 0;
+        }
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+                .count());
+    }
+
+    void RecordTask(size_t slot, uint64_t enqueuedNs, uint64_t startNs, bool helping = false) {
+        if (startNs == 0) {
+            return;
+        }
+        uint64_t endNs = Now();
+        WorkerStats& stats = slots_[slot];
+        if (enqueuedNs != 0 && startNs >= enqueuedNs) {
+            stats.queueWaitNs.record(startNs - enqueuedNs);
+        }
+        if (endNs >= startNs) {
+            stats.runNs.record(endNs - startNs);
+            stats.busyNs.fetch_add(endNs - startNs, std::memory_order_relaxed);
+        }
+        stats.tasks.fetch_add(1, std::memory_order_relaxed);
+        if (helping) {
+            stats.steals.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void RecordIdle(size_t slot, uint64_t startNs) {
+        if (startNs == 0) {
+            return;
+        }
+        uint64_t endNs = Now();
+        if (endNs >= startNs) {
+            slots_[slot].idleNs.fetch_add(endNs - startNs, std::memory_order_relaxed);
+        }
+    }
+
+    PoolStats Snapshot(size_t queueDepth) const {
+        PoolStats snap;
+        snap.queueDepth = queueDepth;
+        snap.workers.resize(slotNum_);
+        for (size_t i = 0; i < slotNum_; i++) {
+            const WorkerStats& stats = slots_[i];
+            snap.workers[i].tasks = stats.tasks.load(std::memory_order_relaxed);
+            snap.workers[i].steals = stats.steals.load(std::memory_order_relaxed);
+            snap.workers[i].busyNs = stats.busyNs.load(std::memory_order_relaxed);
+            snap.workers[i].idleNs = stats.idleNs.load(std::memory_order_relaxed);
+            snap.queueWaitNs.merge(stats.queueWaitNs.snapshot());
+            snap.runNs.merge(stats.runNs.snapshot());
+        }
+        return snap;
+    }
+
+   private:
+    const size_t slotNum_;
+    std::unique_ptr<WorkerStats[]> slots_;
+    std::atomic<bool> enabled_{false};
+};
@@ -0,0 +1,99 @@
+#include "task_graph.h"
+
+TaskGraph::NodeId TaskGraph::Emplace(std::function<void()> work) {
+    nodes_.emplace_back(std::move(work));
+    checked_ = false;
+    return nodes_.size() - 1;
+}
+
+void TaskGraph::Precede(NodeId from, NodeId to) {
+    nodes_[from].successors.push_back(to);
+    nodes_[to].predecessors++;
+    checked_ = false;
+}
+
+size_t TaskGraph::Size() const {
+    return nodes_.size();
+}
+
+bool TaskGraph::Acyclic() {
+    if (checked_) {
+        return acyclic_;
+    }
+
+    std::vector<size_t> indegree(nodes_.size());
+    std::vector<NodeId> ready;
+    for (NodeId id = 0; id < nodes_.size(); id++) {
+        indegree[id] = nodes_[id].predecessors;
+        if (indegree[id] == 0) {
+            ready.push_back(id);
+        }
+    }
+    size_t visited = 0;
+    while (!ready.empty()) {
+        NodeId id = ready.back();
+        ready.pop_back();
+        visited++;
+        for (NodeId succ : nodes_[id].successors) {
+            if (--indegree[succ] == 0) {
+                ready.push_back(succ);
+            }
+        }
+    }
+
+    checked_ = true;
+    acyclic_ = visited == nodes_.size();
+    return acyclic_;
+}
+
+bool TaskGraph::Run(ThreadPool& pool) {
+    if (!Acyclic()) {
+        return false;
+    }
+
+    for (Node& node : nodes_) {
+        node.pending.store(node.predecessors, std::memory_order_relaxed);
+    }
+
+    JoinCounter counter(nodes_.size());
+    for (NodeId id = 0; id < nodes_.size(); id++) {
+        if (nodes_[id].predecessors == 0) {
+            Spawn(pool, id, counter);
+        }
+    }
+    pool.Join(counter);
+    return true;
+}
+
+void TaskGraph::Spawn(ThreadPool& pool, NodeId id, JoinCounter& counter) {
+    if (!pool.Post([this, &pool, id, &counter]() { Execute(pool, id, counter); })) {
+        Execute(pool, id, counter);
+    }
+}
+
+void TaskGraph::Execute(ThreadPool& pool, NodeId id, JoinCounter& counter) {
+    constexpr NodeId NONE = static_cast<NodeId>(-1);
+
+    while (id != NONE) {
+        Node& node = nodes_[id];
+        if (node.work) {
+            node.work();
+        }
+
+        NodeId next = NONE;
+        for (NodeId succ : node.successors) {
+            if (nodes_[succ].pending.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+                continue;
+            }
+            if (next == NONE) {
+                next = succ;
+            } else {
+                Spawn(pool, succ, counter);
+            }
+        }
+
+        // next is still counted as pending, so the counter cannot reach zero while it is held here.
+        counter.Done();
+        id = next;
+    }
+}
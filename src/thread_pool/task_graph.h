@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <vector>
+
+#include "thread_pool/join_counter.h"
+#include "thread_pool/thread_pool_bind.h"
+
+// Static DAG of tasks executed on a ThreadPool.
+// Every node carries an atomic count of unfinished predecessors. The worker that finishes a node
+// decrements its successors, keeps the first one that becomes ready and runs it inline, and posts
+// the others to the pool. The whole run joins on a single counter.
+//
+//   TaskGraph graph;
+//   auto load = graph.Emplace(Load);
+//   auto parse = graph.Emplace(Parse);
+//   graph.Precede(load, parse);
+//   graph.Run(pool);
+class TaskGraph {
+   public:
+    using NodeId = size_t;
+
+   public:
+    TaskGraph() = default;
+    TaskGraph(const TaskGraph&) = delete;
+    TaskGraph& operator=(const TaskGraph&) = delete;
+    TaskGraph(TaskGraph&&) = delete;
+    TaskGraph& operator=(TaskGraph&&) = delete;
+
+    NodeId Emplace(std::function<void()> work);
+    // to starts only after from has finished.
+    void Precede(NodeId from, NodeId to);
+    size_t Size() const;
+
+    // Run every node once and block until all of them finished, helping the pool meanwhile.
+    // Returns false without running anything if the graph contains a cycle.
+    // A graph may be run again once the previous Run has returned.
+    bool Run(ThreadPool& pool);
+
+   private:
+    struct Node {
+        std::function<void()> work;
+        std::vector<NodeId> successors;
+        size_t predecessors{0};
+        std::atomic<size_t> pending{0};
+
+        explicit Node(std::function<void()> func) : work(std::move(func)) {}
+    };
+
+    bool Acyclic();
+    void Execute(ThreadPool& pool, NodeId id, JoinCounter& counter);
+    void Spawn(ThreadPool& pool, NodeId id, JoinCounter& counter);
+
+   private:
+    std::deque<Node> nodes_;
+    bool checked_{false};
+    bool acyclic_{true};
+};
@@ -1,22 +1,32 @@
 #pragma once
 
 #include <atomic>
+#include <algorithm>
 #include <functional>
 #include <future>
+#include <iterator>
 #include <thread>
+#include <utility>
+#include <variant>
 #include <vector>
 
 #include "queue/lock_queue.h"
+#include "thread_pool/cancellation.h"
+#include "thread_pool/pool_stats.h"
 
 void ThreadPoolTest();
 
 template <typename Data>
 class ThreadPool {
    public:
+    // Kept for source compatibility; jobs are queued as Job, which also carries the cancellation
+    // control and the enqueue time.
     using PrmsData = std::pair<Data, std::promise<Data>>;
     using CallBack = std::function<void(Data&)>;
     static const size_t THREAD_NUM_DEFAULT = 4;
     static const size_t THREAD_NUM_MAX = 10;
+    // Upper bound of jobs a worker takes per queue lock while draining.
+    static constexpr size_t DRAIN_BATCH = 32;
 
    public:
     ThreadPool(size_t threadNum, CallBack callback);
@@ -27,29 +37,55 @@ class ThreadPool {
     ThreadPool& operator=(ThreadPool&&) noexcept = default;
 
     std::future<Data> Submit(Data&& data);
+    // Like Submit, but the data is handed back unprocessed with status CANCELLED or EXPIRED
+    // when it is dequeued after control was cancelled or its deadline passed.
+    std::future<TaskResult<Data>> SubmitCancellable(Data&& data, TaskControl control);
     bool Valid();
+    // Stop accepting work and join the workers. With drain the workers first finish everything
+    // already queued, taking it in batches; without drain queued jobs are dropped: cancellable
+    // ones complete as CANCELLED, plain Submit futures see a broken promise.
+    // Returns the number of dropped jobs.
+    size_t Shutdown(bool drain = true);
+    size_t ShutdownNow();
+    // Same as Shutdown(true).
     void Destroy();
     size_t Size();
     size_t SizeDefault() const;
     size_t SizeMax() const;
+    // Queue wait and run time histograms plus per-worker busy/idle time, off by default.
+    void EnableStats(bool enable);
+    PoolStats GetStats();
 
    private:
-    static void ThreadTask(ThreadPool* tp);
+    struct Job {
+        Data data;
+        std::variant<std::promise<Data>, std::promise<TaskResult<Data>>> prms;
+        TaskControl control;
+        uint64_t enqueuedNs{0};
+    };
+
+    static void ThreadTask(ThreadPool* tp, size_t index);
+    void Process(Job& job, size_t index);
+    void Discard(Job& job);
 
    private:
     CallBack callback_{nullptr};
     std::vector<std::thread> threads_;
     std::atomic<bool> ready_{false};
-    lock_queue<PrmsData> queue_;
+    std::atomic<bool> discard_{false};
+    std::atomic<size_t> dropped_{0};
+    lock_queue<Job> queue_;
+    PoolStatsCollector stats_;
 };
 
 template <typename Data>
-inline ThreadPool<Data>::ThreadPool(size_t threadNum, CallBack callback) : callback_(callback) {
+inline ThreadPool<Data>::ThreadPool(size_t threadNum, CallBack callback)
+    : callback_(callback), stats_(threadNum > THREAD_NUM_MAX ? THREAD_NUM_MAX : threadNum) {
     if (callback_) {
         size_t num = threadNum > THREAD_NUM_MAX ? THREAD_NUM_MAX : threadNum;
         ready_.store(num == 0 ? false : true);
         for (uint32_t i = 0; i < num; i++) {
-            threads_.emplace_back(ThreadTask, this);
+            threads_.emplace_back(ThreadTask, this, i);
         }
     }
 }
@@ -64,24 +100,82 @@ inline std::future<Data> ThreadPool<Data>::Submit(Data&& data) {
     if (!callback_) {
         return std::future<Data>();
     }
-    PrmsData prmsData(std::forward<Data>(data), std::promise<Data>());
-    std::future<Data> result = prmsData.second.get_future();
-    queue_.enqueue(std::move(prmsData));
+    Job job{std::forward<Data>(data), std::promise<Data>(), TaskControl(), stats_.Now()};
+    std::future<Data> result = std::get<0>(job.prms).get_future();
+    if (!queue_.enqueue(std::move(job))) {
+        return std::future<Data>();
+    }
+    return result;
+}
+
+template <typename Data>
+inline std::future<TaskResult<Data>> ThreadPool<Data>::SubmitCancellable(Data&& data, TaskControl control) {
+    if (!callback_) {
+        return std::future<TaskResult<Data>>();
+    }
+    Job job{std::forward<Data>(data), std::promise<TaskResult<Data>>(), std::move(control), stats_.Now()};
+    std::future<TaskResult<Data>> result = std::get<1>(job.prms).get_future();
+    if (!queue_.enqueue(std::move(job))) {
+        return std::future<TaskResult<Data>>();
+    }
     return result;
 }
 
 template <typename Data>
-void ThreadPool<Data>::ThreadTask(ThreadPool* tp) {
-    while (tp->ready_.load()) {
-        if (std::optional<PrmsData> data = tp->queue_.dequeue()) {
-            tp->callback_(data.value().first);
-            data.value().second.set_value(std::move(data.value().first));
+void ThreadPool<Data>::ThreadTask(ThreadPool* tp, size_t index) {
+    std::vector<Job> jobs;
+    while (!tp->discard_.load()) {
+        // One job per lock keeps the load spread while running. Once the queue is closed nothing
+        // new arrives, so each worker takes its share of the backlog in one go.
+        size_t batch = 1;
+        if (!tp->ready_.load()) {
+            batch = std::min(DRAIN_BATCH, tp->queue_.size() / tp->threads_.size() + 1);
         }
+        uint64_t idleStart = tp->stats_.Now();
+        if (tp->queue_.dequeue_bulk(std::back_inserter(jobs), batch) == 0) {
+            break;
+        }
+        tp->stats_.RecordIdle(index, idleStart);
+        for (Job& job : jobs) {
+            if (tp->discard_.load()) {
+                tp->Discard(job);
+            } else {
+                tp->Process(job, index);
+            }
+        }
+        jobs.clear();
     }
 }
 
 template <typename Data>
-inline void ThreadPool<Data>::Destroy() {
+void ThreadPool<Data>::Process(Job& job, size_t index) {
+    uint64_t startNs = stats_.Now();
+    if (auto* prms = std::get_if<0>(&job.prms)) {
+        callback_(job.data);
+        prms->set_value(std::move(job.data));
+    } else {
+        TaskStatus status = job.control.Check();
+        if (status == TaskStatus::COMPLETED) {
+            callback_(job.data);
+        }
+        std::get<1>(job.prms).set_value(TaskResult<Data>{status, std::move(job.data)});
+    }
+    stats_.RecordTask(index, job.enqueuedNs, startNs);
+}
+
+template <typename Data>
+void ThreadPool<Data>::Discard(Job& job) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    if (auto* prms = std::get_if<1>(&job.prms)) {
+        prms->set_value(TaskResult<Data>{TaskStatus::CANCELLED, std::move(job.data)});
+    }
+}
+
+template <typename Data>
+inline size_t ThreadPool<Data>::Shutdown(bool drain) {
+    if (!drain) {
+        discard_.store(true);
+    }
     ready_.store(false);
     queue_.close();
     for (auto& th : threads_) {
@@ -90,6 +184,26 @@ inline void ThreadPool<Data>::Destroy() {
         }
     }
     threads_.clear();
+
+    // Only left behind when the workers stopped without draining.
+    std::vector<Job> jobs;
+    while (queue_.dequeue_bulk(std::back_inserter(jobs), DRAIN_BATCH) != 0) {
+        for (Job& job : jobs) {
+            Discard(job);
+        }
+        jobs.clear();
+    }
+    return dropped_.exchange(0, std::memory_order_relaxed);
+}
+
+template <typename Data>
+inline size_t ThreadPool<Data>::ShutdownNow() {
+    return Shutdown(false);
+}
+
+template <typename Data>
+inline void ThreadPool<Data>::Destroy() {
+    Shutdown(true);
 }
 
 template <typename Data>
@@ -111,3 +225,13 @@ template <typename Data>
 inline size_t ThreadPool<Data>::SizeMax() const {
     return THREAD_NUM_MAX;
 }
+
+template <typename Data>
+inline void ThreadPool<Data>::EnableStats(bool enable) {
+    stats_.Enable(enable);
+}
+
+template <typename Data>
+inline PoolStats ThreadPool<Data>::GetStats() {
+    return stats_.Snapshot(queue_.size());
+}
@@ -1,35 +1,248 @@
 #include "thread_pool_bind.h"
 
+#include <algorithm>
+
+#include "opt/back_off.h"
+
 const size_t ThreadPool::THREAD_NUM_DEFAULT = 4;
 const size_t ThreadPool::THREAD_NUM_MAX = 10;
+const size_t ThreadPool::STARVATION_LIMIT = 16;
+const size_t ThreadPool::DRAIN_BATCH = 32;
+const std::chrono::nanoseconds ThreadPool::TIMER_TICK = std::chrono::milliseconds(1);
+
+namespace {
+// Set for the lifetime of a worker thread, so that Join can credit helping to the right slot.
+thread_local const ThreadPool* tls_worker_pool = nullptr;
+thread_local size_t tls_worker_index = 0;
+}  // namespace
 
-ThreadPool::ThreadPool(size_t thread_num) {
+ThreadPool::ThreadPool(size_t thread_num) : stats_(thread_num > THREAD_NUM_MAX ? THREAD_NUM_MAX : thread_num) {
     size_t num = thread_num > THREAD_NUM_MAX ? THREAD_NUM_MAX : thread_num;
     stop_.store(thread_num == 0 ? true : false);
     for (size_t i = 0; i < num; ++i) {
-        threads_.emplace_back(ThreadTask, this);
+        threads_.emplace_back(ThreadTask, this, i);
+    }
+}
+
+void ThreadPool::ThreadTask(ThreadPool* thread_pool, size_t index) {
+    tls_worker_pool = thread_pool;
+    tls_worker_index = index;
+    std::vector<QueuedTask> batch;
+    while (!thread_pool->discard_) {
+        if (thread_pool->stop_) {
+            // Draining: nothing new is accepted, so leave once the backlog is gone.
+            if (thread_pool->RunPendingBatch(index, batch)) {
+                continue;
+            }
+            break;
+        }
+        if (thread_pool->RunPendingTask(index)) {
+            continue;
+        }
+        uint64_t idleStart = thread_pool->stats_.Now();
+        thread_pool->WaitForTask();
+        thread_pool->stats_.RecordIdle(index, idleStart);
+    }
+}
+
+void ThreadPool::Enqueue(Priority priority, Task task) {
+    {
+        std::unique_lock<std::mutex> lock(task_mtx_);
+        tasks_[static_cast<size_t>(priority)].push(QueuedTask{std::move(task), stats_.Now()});
+        task_num_.fetch_add(1, std::memory_order_relaxed);
+    }
+    idle_.notify_one();
+}
+
+// Spin briefly on the lock-free task count, then announce the intent to sleep and park.
+// A task published after prepare_wait() either is seen by the re-check or moves the epoch.
+void ThreadPool::WaitForTask() {
+    back_off<IdleSpinTraits> bkoff;
+    while (!bkoff.exhausted()) {
+        if (stop_ || task_num_.load(std::memory_order_relaxed) != 0) {
+            return;
+        }
+        bkoff();
+    }
+
+    event_count::key key = idle_.prepare_wait();
+    if (stop_ || task_num_.load(std::memory_order_seq_cst) != 0) {
+        idle_.cancel_wait();
+        return;
+    }
+    idle_.wait(key);
+}
+
+// Caller must hold task_mtx_.
+bool ThreadPool::PopTask(QueuedTask& task) {
+    if (task_num_.load(std::memory_order_relaxed) == 0) {
+        return false;
+    }
+
+    size_t lane = 0;
+    while (tasks_[lane].empty()) {
+        lane++;
+    }
+    for (size_t aged = PRIORITY_NUM - 1; aged > lane; aged--) {
+        if (!tasks_[aged].empty() && skipped_[aged] >= STARVATION_LIMIT) {
+            lane = aged;
+            break;
+        }
+    }
+    for (size_t lower = lane + 1; lower < PRIORITY_NUM; lower++) {
+        if (!tasks_[lower].empty()) {
+            skipped_[lower]++;
+        }
+    }
+    skipped_[lane] = 0;
+
+    task = std::move(tasks_[lane].front());
+    tasks_[lane].pop();
+    task_num_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool ThreadPool::RunPendingTask(size_t slot, bool helping) {
+    if (task_num_.load(std::memory_order_relaxed) == 0) {
+        return false;
+    }
+
+    QueuedTask task;
+    {
+        std::unique_lock<std::mutex> lock(task_mtx_);
+        if (!PopTask(task)) {
+            return false;
+        }
+    }
+    uint64_t startNs = stats_.Now();
+    task.func();
+    stats_.RecordTask(slot, task.enqueuedNs, startNs, helping);
+    return true;
+}
+
+// Pops this worker's share of the backlog under a single lock, lanes are still served in order.
+bool ThreadPool::RunPendingBatch(size_t slot, std::vector<QueuedTask>& batch) {
+    {
+        std::unique_lock<std::mutex> lock(task_mtx_);
+        size_t share = std::min(DRAIN_BATCH, task_num_.load(std::memory_order_relaxed) / threads_.size() + 1);
+        QueuedTask task;
+        while (batch.size() < share && PopTask(task)) {
+            batch.push_back(std::move(task));
+        }
+    }
+    if (batch.empty()) {
+        return false;
+    }
+
+    for (QueuedTask& task : batch) {
+        uint64_t startNs = stats_.Now();
+        task.func();
+        stats_.RecordTask(slot, task.enqueuedNs, startNs);
+    }
+    batch.clear();
+    return true;
+}
+
+size_t ThreadPool::HelpingSlot() const {
+    return tls_worker_pool == this ? tls_worker_index : stats_.HelperSlot();
+}
+
+void ThreadPool::Join(JoinCounter& counter) {
+    size_t slot = HelpingSlot();
+    while (!counter.Finished() && RunPendingTask(slot, true)) {
     }
+    counter.Wait();
 }
 
-void ThreadPool::ThreadTask(ThreadPool* thread_pool) {
-    auto next = [thread_pool](Task& task) -> bool {
-        task = nullptr;
-        std::unique_lock<std::mutex> lock(thread_pool->task_mtx_);
-        thread_pool->task_cv_.wait(lock, [thread_pool] { return thread_pool->stop_ || !thread_pool->tasks_.empty(); });
-        if (!thread_pool->stop_ && !thread_pool->tasks_.empty()) {
-            task = std::move(thread_pool->tasks_.front());
-            thread_pool->tasks_.pop();
+uint64_t ThreadPool::ToTick(Clock::time_point timePoint) const {
+    if (timePoint <= timer_epoch_) {
+        return 0;
+    }
+    // Round up so that a timer never fires before its time point.
+    return static_cast<uint64_t>((timePoint - timer_epoch_ + TIMER_TICK - std::chrono::nanoseconds(1)) / TIMER_TICK);
+}
+
+ThreadPool::TimerId ThreadPool::AddTimer(Clock::time_point expire, std::chrono::nanoseconds period, Task task) {
+    if (Valid() != true) {
+        return TimingWheel::INVALID_TIMER;
+    }
+
+    uint64_t periodTicks = 0;
+    if (period > std::chrono::nanoseconds::zero()) {
+        periodTicks = static_cast<uint64_t>((period + TIMER_TICK - std::chrono::nanoseconds(1)) / TIMER_TICK);
+    }
+    uint64_t expireTick = ToTick(expire);
+
+    std::unique_lock<std::mutex> lock(timer_mtx_);
+    if (timer_stop_) {
+        return TimingWheel::INVALID_TIMER;
+    }
+    if (!timer_.joinable()) {
+        timer_ = std::thread(TimerTask, this);
+    }
+    TimerId id = wheel_.Add(expireTick, periodTicks, std::move(task));
+    bool wake = expireTick < timer_wake_tick_;
+    lock.unlock();
+
+    if (wake) {
+        timer_cv_.notify_one();
+    }
+    return id;
+}
+
+bool ThreadPool::CancelTimer(TimerId id) {
+    std::lock_guard<std::mutex> lock(timer_mtx_);
+    return wheel_.Cancel(id);
+}
+
+void ThreadPool::TimerTask(ThreadPool* thread_pool) {
+    std::vector<Task> due;
+    std::unique_lock<std::mutex> lock(thread_pool->timer_mtx_);
+    while (!thread_pool->timer_stop_) {
+        // Only ticks that have fully elapsed are due.
+        uint64_t now = static_cast<uint64_t>((Clock::now() - thread_pool->timer_epoch_) / TIMER_TICK);
+        thread_pool->wheel_.Advance(now, [&due](TimingWheel::Callback callback) { due.push_back(std::move(callback)); });
+
+        if (!due.empty()) {
+            lock.unlock();
+            for (Task& task : due) {
+                thread_pool->Post(std::move(task));
+            }
+            due.clear();
+            lock.lock();
+            continue;
         }
-        return static_cast<bool>(task);
-    };
-    Task task;
-    while (!thread_pool->stop_) {
-        if (next(task)) {
-            task();
+
+        if (thread_pool->wheel_.Empty()) {
+            thread_pool->timer_wake_tick_ = UINT64_MAX;
+            thread_pool->timer_cv_.wait(lock);
+        } else {
+            thread_pool->timer_wake_tick_ = thread_pool->wheel_.NextTick();
+            thread_pool->timer_cv_.wait_until(lock,
+                                              thread_pool->timer_epoch_ + thread_pool->timer_wake_tick_ * TIMER_TICK);
         }
     }
 }
 
+void ThreadPool::StopTimer() {
+    {
+        std::lock_guard<std::mutex> lock(timer_mtx_);
+        timer_stop_ = true;
+    }
+    timer_cv_.notify_one();
+    if (timer_.joinable()) {
+        timer_.join();
+    }
+}
+
+void ThreadPool::EnableStats(bool enable) {
+    stats_.Enable(enable);
+}
+
+PoolStats ThreadPool::GetStats() const {
+    return stats_.Snapshot(task_num_.load(std::memory_order_relaxed));
+}
+
 size_t ThreadPool::GetThreadNum() {
     return threads_.size();
 }
@@ -38,15 +251,45 @@ bool ThreadPool::Valid() {
     return threads_.size() != 0 && stop_ != true;
 }
 
-void ThreadPool::Destroy() {
+size_t ThreadPool::Shutdown(bool drain) {
+    StopTimer();
+    if (!drain) {
+        discard_.store(true);
+    }
     stop_.store(true);
-    task_cv_.notify_all();
+    idle_.notify_all();
     for (std::thread& thd : threads_) {
         if (thd.joinable()) {
             thd.join();
         }
     }
     threads_.clear();
+
+    // A Push that passed Valid() just before stop_ may land after the workers left.
+    if (drain) {
+        while (RunPendingTask(stats_.HelperSlot())) {
+        }
+        return 0;
+    }
+    std::array<std::queue<QueuedTask>, PRIORITY_NUM> dropped;
+    {
+        std::lock_guard<std::mutex> lock(task_mtx_);
+        dropped.swap(tasks_);
+        task_num_.store(0, std::memory_order_relaxed);
+    }
+    size_t count = 0;
+    for (const std::queue<QueuedTask>& lane : dropped) {
+        count += lane.size();
+    }
+    return count;
+}
+
+size_t ThreadPool::ShutdownNow() {
+    return Shutdown(false);
+}
+
+void ThreadPool::Destroy() {
+    Shutdown(true);
 }
 
 ThreadPool::~ThreadPool() {
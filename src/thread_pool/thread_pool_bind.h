@@ -1,4 +1,8 @@
+#pragma once
+
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <functional>
 #include <future>
@@ -7,7 +11,21 @@
 #include <thread>
 #include <vector>
 
+#include "opt/event_count.h"
+#include "thread_pool/cancellation.h"
+#include "thread_pool/join_counter.h"
+#include "thread_pool/pool_stats.h"
+#include "thread_pool/timing_wheel.h"
+
 class ThreadPool {
+   public:
+    // Lanes are served strictly from HIGH to LOW, except that a non-empty lower lane skipped
+    // STARVATION_LIMIT times in a row is served once, so bulk work cannot be starved forever.
+    enum class Priority : size_t { HIGH = 0, NORMAL, LOW };
+    static constexpr size_t PRIORITY_NUM = 3;
+    using TimerId = TimingWheel::TimerId;
+    using Clock = std::chrono::steady_clock;
+
    public:
     explicit ThreadPool(size_t thread_num = THREAD_NUM_DEFAULT);
     ThreadPool(const ThreadPool&) = delete;
@@ -16,30 +34,124 @@ class ThreadPool {
     ThreadPool& operator=(ThreadPool&&) = delete;
     ~ThreadPool();
 
+    // Stop accepting work and join the workers. Pending timers are cancelled first. With drain the
+    // workers finish every queued task, taking them in batches; without drain queued tasks are
+    // destroyed unrun and their futures see a broken promise. Returns the number of dropped tasks.
+    size_t Shutdown(bool drain = true);
+    size_t ShutdownNow();
+    // Same as Shutdown(true).
     void Destroy();
     size_t GetThreadNum();
     bool Valid();
+    // Queue wait and run time histograms plus per-worker busy/idle time, off by default.
+    void EnableStats(bool enable);
+    PoolStats GetStats() const;
     template <typename F, typename... Args>
     auto Push(F&& f, Args&&... args) -> std::future<decltype(f(args...))>;
+    template <typename F, typename... Args>
+    auto PushPriority(Priority priority, F&& f, Args&&... args) -> std::future<decltype(f(args...))>;
+    // Like Push, but the task is discarded when it is dequeued after control was cancelled or
+    // its deadline passed; the future then reports CANCELLED or EXPIRED and holds no value.
+    template <typename F, typename... Args>
+    auto PushCancellable(TaskControl control, F&& f, Args&&... args)
+        -> std::future<TaskResult<decltype(f(args...))>>;
+    // Fire-and-forget submission, no future is allocated. Returns false if the pool is not running.
+    template <typename F>
+    bool Post(F&& f);
+    template <typename F>
+    bool PostPriority(Priority priority, F&& f);
+
+    // Timers are kept in a hierarchical timing wheel with TIMER_TICK resolution, driven by one
+    // timer thread started on first use. Due callbacks are handed to the workers like Post.
+    // Returns TimingWheel::INVALID_TIMER if the pool is not running.
+    template <typename F>
+    TimerId PushAfter(std::chrono::nanoseconds delay, F&& f);
+    template <typename F>
+    TimerId PushAt(Clock::time_point timePoint, F&& f);
+    template <typename F>
+    TimerId PushEvery(std::chrono::nanoseconds period, F&& f);
+    // Returns false if the timer already fired (one-shot) or does not exist.
+    bool CancelTimer(TimerId id);
+
+    // Block until counter finishes, running queued tasks on the calling thread meanwhile,
+    // so that nested fork/join regions issued from a worker cannot starve the pool.
+    void Join(JoinCounter& counter);
+
+    // Call f(i) for every i in [begin, end). The range is split recursively at multiples of grain,
+    // each split hands the upper half to the pool and keeps the lower half, and all chunks join on
+    // a single counter. The calling thread takes part in the work.
+    template <typename Index, typename F>
+    void ParallelFor(Index begin, Index end, Index grain, F&& f);
+    // Fold reduce(acc, map(i)) over [begin, end). Partial results are combined in index order,
+    // so reduce only needs to be associative; identity must be its neutral element.
+    template <typename Index, typename T, typename Map, typename Reduce>
+    T ParallelReduce(Index begin, Index end, Index grain, T identity, Map&& map, Reduce&& reduce);
 
    private:
-    static void ThreadTask(ThreadPool* thread_pool);
+    using Task = std::function<void()>;
+
+    struct QueuedTask {
+        Task func;
+        uint64_t enqueuedNs;
+    };
+
+    static void ThreadTask(ThreadPool* thread_pool, size_t index);
+    void Enqueue(Priority priority, Task task);
+    bool RunPendingTask(size_t slot, bool helping = false);
+    // The calling worker's own stats slot, or the shared helper slot for any other thread.
+    size_t HelpingSlot() const;
+    bool RunPendingBatch(size_t slot, std::vector<QueuedTask>& batch);
+    bool PopTask(QueuedTask& task);
+    void WaitForTask();
+    TimerId AddTimer(Clock::time_point expire, std::chrono::nanoseconds period, Task task);
+    uint64_t ToTick(Clock::time_point timePoint) const;
+    static void TimerTask(ThreadPool* thread_pool);
+    void StopTimer();
+    template <typename Index, typename Leaf>
+    void SplitRange(Index begin, Index end, Index grain, Leaf& leaf, JoinCounter& counter);
 
    public:
     static const size_t THREAD_NUM_DEFAULT;
     static const size_t THREAD_NUM_MAX;
+    static const size_t STARVATION_LIMIT;
+    static const size_t DRAIN_BATCH;
+    static const std::chrono::nanoseconds TIMER_TICK;
+
+    // Idle workers spin with exponential back-off up to this bound before parking.
+    struct IdleSpinTraits {
+        static constexpr size_t lower_bound = 16;
+        static constexpr size_t upper_bound = 256;
+    };
 
    private:
-    using Task = std::function<void()>;
     std::vector<std::thread> threads_;
-    std::queue<Task> tasks_;
+    std::array<std::queue<QueuedTask>, PRIORITY_NUM> tasks_;
+    std::array<size_t, PRIORITY_NUM> skipped_{};
+    std::atomic<size_t> task_num_{0};
     std::mutex task_mtx_;
-    std::condition_variable task_cv_;
+    // Push only issues a wakeup when a worker has announced that it is about to park.
+    event_count idle_;
     std::atomic<bool> stop_{false};
+    std::atomic<bool> discard_{false};
+    PoolStatsCollector stats_;
+
+    std::thread timer_;
+    std::mutex timer_mtx_;
+    std::condition_variable timer_cv_;
+    TimingWheel wheel_;
+    const Clock::time_point timer_epoch_{Clock::now()};
+    // Tick the timer thread sleeps until, an earlier timer has to wake it up.
+    uint64_t timer_wake_tick_{UINT64_MAX};
+    bool timer_stop_{false};
 };
 
 template <typename F, typename... Args>
 auto ThreadPool::Push(F&& f, Args&&... args) -> std::future<decltype(f(args...))> {
+    return PushPriority(Priority::NORMAL, std::forward<F>(f), std::forward<Args>(args)...);
+}
+
+template <typename F, typename... Args>
+auto ThreadPool::PushPriority(Priority priority, F&& f, Args&&... args) -> std::future<decltype(f(args...))> {
     if (Valid() != true) {
         return std::future<decltype(f(args...))>();
     }
@@ -47,13 +159,123 @@ auto ThreadPool::Push(F&& f, Args&&... args) -> std::future<decltype(f(args...))
     using return_type = decltype(f(args...))();
     std::function<return_type> func = std::bind(std::forward<F>(f), std::forward<Args>(args)...);
     auto func_ptr = std::make_shared<std::packaged_task<return_type>>(func);
-    Task task = [func_ptr]() { (*func_ptr)(); };
+    Enqueue(priority, [func_ptr]() { (*func_ptr)(); });
+    return func_ptr->get_future();
+}
 
-    {
-        std::unique_lock<std::mutex> lock(task_mtx_);
-        tasks_.emplace(task);
+template <typename F, typename... Args>
+auto ThreadPool::PushCancellable(TaskControl control, F&& f, Args&&... args)
+    -> std::future<TaskResult<decltype(f(args...))>> {
+    using value_type = decltype(f(args...));
+    using result_type = TaskResult<value_type>;
+    if (Valid() != true) {
+        return std::future<result_type>();
     }
 
-    task_cv_.notify_one();
-    return func_ptr->get_future();
+    std::function<value_type()> func = std::bind(std::forward<F>(f), std::forward<Args>(args)...);
+    auto prms_ptr = std::make_shared<std::promise<result_type>>();
+    std::future<result_type> result = prms_ptr->get_future();
+    Enqueue(Priority::NORMAL, [prms_ptr, func, control]() {
+        TaskStatus status = control.Check();
+        if constexpr (std::is_void_v<value_type>) {
+            if (status == TaskStatus::COMPLETED) {
+                func();
+            }
+            prms_ptr->set_value(result_type{status});
+        } else if (status != TaskStatus::COMPLETED) {
+            prms_ptr->set_value(result_type{status, std::nullopt});
+        } else {
+            prms_ptr->set_value(result_type{TaskStatus::COMPLETED, func()});
+        }
+    });
+    return result;
+}
+
+template <typename F>
+bool ThreadPool::Post(F&& f) {
+    return PostPriority(Priority::NORMAL, std::forward<F>(f));
+}
+
+template <typename F>
+bool ThreadPool::PostPriority(Priority priority, F&& f) {
+    if (Valid() != true) {
+        return false;
+    }
+
+    Enqueue(priority, Task(std::forward<F>(f)));
+    return true;
+}
+
+template <typename F>
+ThreadPool::TimerId ThreadPool::PushAfter(std::chrono::nanoseconds delay, F&& f) {
+    return AddTimer(Clock::now() + delay, std::chrono::nanoseconds::zero(), Task(std::forward<F>(f)));
+}
+
+template <typename F>
+ThreadPool::TimerId ThreadPool::PushAt(Clock::time_point timePoint, F&& f) {
+    return AddTimer(timePoint, std::chrono::nanoseconds::zero(), Task(std::forward<F>(f)));
+}
+
+template <typename F>
+ThreadPool::TimerId ThreadPool::PushEvery(std::chrono::nanoseconds period, F&& f) {
+    return AddTimer(Clock::now() + period, period, Task(std::forward<F>(f)));
+}
+
+template <typename Index, typename Leaf>
+void ThreadPool::SplitRange(Index begin, Index end, Index grain, Leaf& leaf, JoinCounter& counter) {
+    while (end - begin >= grain * 2) {
+        Index mid = begin + (end - begin) / grain / 2 * grain;
+        auto upper = [this, mid, end, grain, &leaf, &counter]() { SplitRange(mid, end, grain, leaf, counter); };
+        if (!Post(upper)) {
+            upper();
+        }
+        end = mid;
+    }
+    leaf(begin, end);
+    counter.Done(static_cast<size_t>(end - begin));
+}
+
+template <typename Index, typename F>
+void ThreadPool::ParallelFor(Index begin, Index end, Index grain, F&& f) {
+    if (begin >= end) {
+        return;
+    }
+    grain = grain > 0 ? grain : 1;
+
+    auto leaf = [&f](Index first, Index last) {
+        for (Index i = first; i < last; ++i) {
+            f(i);
+        }
+    };
+    JoinCounter counter(static_cast<size_t>(end - begin));
+    SplitRange(begin, end, grain, leaf, counter);
+    Join(counter);
+}
+
+template <typename Index, typename T, typename Map, typename Reduce>
+T ThreadPool::ParallelReduce(Index begin, Index end, Index grain, T identity, Map&& map, Reduce&& reduce) {
+    if (begin >= end) {
+        return identity;
+    }
+    grain = grain > 0 ? grain : 1;
+
+    // Chunks always start at begin + k * grain, so k is a stable slot for the partial result.
+    size_t chunks = static_cast<size_t>((end - begin) / grain);
+    std::vector<T> partials(chunks > 0 ? chunks : 1, identity);
+    auto leaf = [begin, grain, &identity, &partials, &map, &reduce](Index first, Index last) {
+        T acc = identity;
+        for (Index i = first; i < last; ++i) {
+            acc = reduce(std::move(acc), map(i));
+        }
+        partials[static_cast<size_t>((first - begin) / grain)] = std::move(acc);
+    };
+    JoinCounter counter(static_cast<size_t>(end - begin));
+    SplitRange(begin, end, grain, leaf, counter);
+    Join(counter);
+
+    T result = std::move(identity);
+    for (T& partial : partials) {
+        result = reduce(std::move(result), std::move(partial));
+    }
+    return result;
 }
@@ -0,0 +1,296 @@
+#pragma once
+
+#if !defined(__cpp_impl_coroutine)
+#error "thread_pool_coro.h requires C++20 coroutine support"
+#endif
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "thread_pool/join_counter.h"
+#include "thread_pool/thread_pool_bind.h"
+
+// Lazily started coroutine returning T. The body starts running when the task is awaited
+// and the awaiting coroutine is resumed by symmetric transfer on the thread that finished it,
+// so a fan-out written as co_await WhenAll(...) never blocks a worker.
+//
+//   CoTask<int> Fetch(ThreadPool& pool, int key) {
+//       co_await Schedule(pool);
+//       co_return Lookup(key);
+//   }
+template <typename T = void>
+class CoTask;
+
+// co_await Schedule(pool) suspends the coroutine and resumes it on a pool worker.
+// If the pool is not running the coroutine simply continues on the current thread.
+class ScheduleAwaiter {
+   public:
+    ScheduleAwaiter(ThreadPool& pool, ThreadPool::Priority priority) : pool_(pool), priority_(priority) {}
+    bool await_ready() const noexcept {
+        return false;
+    }
+    bool await_suspend(std::coroutine_handle<> handle) {
+        return pool_.PostPriority(priority_, [handle]() { handle.resume(); });
+    }
+    void await_resume() const noexcept {}
+
+   private:
+    ThreadPool& pool_;
+    ThreadPool::Priority priority_;
+};
+
+inline ScheduleAwaiter Schedule(ThreadPool& pool, ThreadPool::Priority priority = ThreadPool::Priority::NORMAL) {
+    return ScheduleAwaiter(pool, priority);
+}
+
+namespace detail {
+namespace coro {
+
+struct FinalAwaiter {
+    bool await_ready() const noexcept {
+        return false;
+    }
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+        std::coroutine_handle<> continuation = handle.promise().continuation_;
+        return continuation ? continuation : std::noop_coroutine();
+    }
+    void await_resume() const noexcept {}
+};
+
+struct PromiseBase {
+    std::suspend_always initial_suspend() const noexcept {
+        return {};
+    }
+    FinalAwaiter final_suspend() const noexcept {
+        return {};
+    }
+    void unhandled_exception() const noexcept {
+        std::terminate();
+    }
+
+    std::coroutine_handle<> continuation_;
+};
+
+template <typename T>
+struct Promise : PromiseBase {
+    CoTask<T> get_return_object() noexcept;
+    template <typename U>
+    void return_value(U&& value) {
+        value_.emplace(std::forward<U>(value));
+    }
+
+    std::optional<T> value_;
+};
+
+template <>
+struct Promise<void> : PromiseBase {
+    CoTask<void> get_return_object() noexcept;
+    void return_void() const noexcept {}
+};
+
+// Eagerly started, self-destroying coroutine used to drive a CoTask from non-coroutine code.
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() const noexcept {
+            return {};
+        }
+        std::suspend_never initial_suspend() const noexcept {
+            return {};
+        }
+        std::suspend_never final_suspend() const noexcept {
+            return {};
+        }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept {
+            std::terminate();
+        }
+    };
+};
+
+}  // namespace coro
+}  // namespace detail
+
+template <typename T>
+class [[nodiscard]] CoTask {
+   public:
+    using promise_type = detail::coro::Promise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+   public:
+    explicit CoTask(Handle handle) : handle_(handle) {}
+    ~CoTask() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+    CoTask(const CoTask&) = delete;
+    CoTask& operator=(const CoTask&) = delete;
+    CoTask(CoTask&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+    CoTask& operator=(CoTask&& other) noexcept {
+        if (this != &other) {
+            if (handle_) {
+                handle_.destroy();
+            }
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+
+    bool await_ready() const noexcept {
+        return !handle_ || handle_.done();
+    }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle_.promise().continuation_ = awaiting;
+        return handle_;
+    }
+    T await_resume() {
+        if constexpr (!std::is_void_v<T>) {
+            return std::move(*handle_.promise().value_);
+        }
+    }
+
+   private:
+    Handle handle_;
+};
+
+namespace detail {
+namespace coro {
+
+template <typename T>
+inline CoTask<T> Promise<T>::get_return_object() noexcept {
+    return CoTask<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline CoTask<void> Promise<void>::get_return_object() noexcept {
+    return CoTask<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+template <typename T>
+Detached SyncWaitDriver(CoTask<T>& task, std::optional<T>& result, JoinCounter& counter) {
+    result.emplace(co_await task);
+    counter.Done();
+}
+
+inline Detached SyncWaitDriver(CoTask<void>& task, JoinCounter& counter) {
+    co_await task;
+    counter.Done();
+}
+
+// Counts the children of a WhenAll plus one for the parent itself; whoever arrives last
+// resumes the parent, which is either the final child or the parent that never suspends.
+class WhenAllLatch {
+   public:
+    explicit WhenAllLatch(size_t count) : pending_(count + 1) {}
+
+    void Arrive() {
+        if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            parent_.resume();
+        }
+    }
+    bool TrySuspend(std::coroutine_handle<> parent) {
+        parent_ = parent;
+        return pending_.fetch_sub(1, std::memory_order_acq_rel) != 1;
+    }
+
+   private:
+    std::atomic<size_t> pending_;
+    std::coroutine_handle<> parent_;
+};
+
+template <typename T>
+Detached WhenAllDriver(CoTask<T>& task, std::optional<T>& result, WhenAllLatch& latch) {
+    result.emplace(co_await task);
+    latch.Arrive();
+}
+
+inline Detached WhenAllDriver(CoTask<void>& task, WhenAllLatch& latch) {
+    co_await task;
+    latch.Arrive();
+}
+
+template <typename T>
+class WhenAllAwaiter {
+   public:
+    WhenAllAwaiter(std::vector<CoTask<T>>& tasks, std::vector<std::optional<T>>& results)
+        : tasks_(tasks), results_(results), latch_(tasks.size()) {}
+
+    bool await_ready() const noexcept {
+        return tasks_.empty();
+    }
+    bool await_suspend(std::coroutine_handle<> parent) {
+        for (size_t i = 0; i < tasks_.size(); i++) {
+            WhenAllDriver(tasks_[i], results_[i], latch_);
+        }
+        return latch_.TrySuspend(parent);
+    }
+    void await_resume() const noexcept {}
+
+   private:
+    std::vector<CoTask<T>>& tasks_;
+    std::vector<std::optional<T>>& results_;
+    WhenAllLatch latch_;
+};
+
+template <>
+class WhenAllAwaiter<void> {
+   public:
+    explicit WhenAllAwaiter(std::vector<CoTask<void>>& tasks) : tasks_(tasks), latch_(tasks.size()) {}
+
+    bool await_ready() const noexcept {
+        return tasks_.empty();
+    }
+    bool await_suspend(std::coroutine_handle<> parent) {
+        for (CoTask<void>& task : tasks_) {
+            WhenAllDriver(task, latch_);
+        }
+        return latch_.TrySuspend(parent);
+    }
+    void await_resume() const noexcept {}
+
+   private:
+    std::vector<CoTask<void>>& tasks_;
+    WhenAllLatch latch_;
+};
+
+}  // namespace coro
+}  // namespace detail
+
+// Start all tasks and resume once every one of them has finished. Results keep the order of tasks.
+// Tasks run wherever they schedule themselves, typically by starting with co_await Schedule(pool).
+template <typename T>
+CoTask<std::vector<T>> WhenAll(std::vector<CoTask<T>> tasks) {
+    std::vector<std::optional<T>> slots(tasks.size());
+    co_await detail::coro::WhenAllAwaiter<T>(tasks, slots);
+
+    std::vector<T> results;
+    results.reserve(slots.size());
+    for (std::optional<T>& slot : slots) {
+        results.push_back(std::move(*slot));
+    }
+    co_return results;
+}
+
+inline CoTask<void> WhenAll(std::vector<CoTask<void>> tasks) {
+    co_await detail::coro::WhenAllAwaiter<void>(tasks);
+}
+
+// Block the calling (non-coroutine) thread until task has finished and return its result.
+// Must not be called from a pool worker that the task itself needs to make progress.
+template <typename T>
+T SyncWait(CoTask<T> task) {
+    JoinCounter counter(1);
+    if constexpr (std::is_void_v<T>) {
+        detail::coro::SyncWaitDriver(task, counter);
+        counter.Wait();
+    } else {
+        std::optional<T> result;
+        detail::coro::SyncWaitDriver(task, result, counter);
+        counter.Wait();
+        return std::move(*result);
+    }
+}
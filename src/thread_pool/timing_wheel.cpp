@@ -0,0 +1,113 @@
+#include "timing_wheel.h"
+
+TimingWheel::~TimingWheel() {
+    for (auto& entry : timers_) {
+        delete entry.second;
+    }
+}
+
+TimingWheel::TimerId TimingWheel::Add(uint64_t expire, uint64_t period, Callback callback) {
+    Timer* timer = new Timer{nextId_++, expire > now_ ? expire : now_ + 1, period, std::move(callback)};
+    timers_.emplace(timer->id, timer);
+    Place(timer);
+    return timer->id;
+}
+
+bool TimingWheel::Cancel(TimerId id) {
+    auto it = timers_.find(id);
+    if (it == timers_.end()) {
+        return false;
+    }
+    Timer* timer = it->second;
+    timers_.erase(it);
+    // A timer collected by the running Tick is only unlinked from expired_ by Advance itself.
+    for (Timer*& expired : expired_) {
+        if (expired == timer) {
+            expired = nullptr;
+        }
+    }
+    Unlink(timer);
+    delete timer;
+    return true;
+}
+
+uint64_t TimingWheel::NextTick() const {
+    for (uint64_t tick = now_ + 1;; tick++) {
+        if (slots_[0][tick & (SLOT_NUM - 1)] != nullptr || (tick & (SLOT_NUM - 1)) == 0) {
+            return tick;
+        }
+    }
+}
+
+void TimingWheel::Place(Timer* timer) {
+    uint64_t diff = timer->expire ^ now_;
+    for (size_t level = 0; level < LEVEL_NUM; level++) {
+        if ((diff >> ((level + 1) * LEVEL_BITS)) == 0) {
+            Link(timer, level, (timer->expire >> (level * LEVEL_BITS)) & (SLOT_NUM - 1));
+            return;
+        }
+    }
+    Link(timer, OVERFLOW_LEVEL, 0);
+}
+
+TimingWheel::Timer*& TimingWheel::Head(size_t level, size_t slot) {
+    return level == OVERFLOW_LEVEL ? overflow_ : slots_[level][slot];
+}
+
+void TimingWheel::Link(Timer* timer, size_t level, size_t slot) {
+    Timer*& head = Head(level, slot);
+    timer->level = level;
+    timer->slot = slot;
+    timer->prev = nullptr;
+    timer->next = head;
+    if (head != nullptr) {
+        head->prev = timer;
+    }
+    head = timer;
+}
+
+void TimingWheel::Unlink(Timer* timer) {
+    if (timer->prev != nullptr) {
+        timer->prev->next = timer->next;
+    } else if (Head(timer->level, timer->slot) == timer) {
+        Head(timer->level, timer->slot) = timer->next;
+    }
+    if (timer->next != nullptr) {
+        timer->next->prev = timer->prev;
+    }
+    timer->prev = nullptr;
+    timer->next = nullptr;
+}
+
+void TimingWheel::Cascade(size_t level, size_t slot) {
+    Timer* timer = Head(level, slot);
+    Head(level, slot) = nullptr;
+    while (timer != nullptr) {
+        Timer* next = timer->next;
+        Place(timer);
+        timer = next;
+    }
+}
+
+void TimingWheel::Tick() {
+    now_++;
+
+    if ((now_ & ((uint64_t{1} << (LEVEL_NUM * LEVEL_BITS)) - 1)) == 0) {
+        Cascade(OVERFLOW_LEVEL, 0);
+    }
+    for (size_t level = LEVEL_NUM - 1; level > 0; level--) {
+        if ((now_ & ((uint64_t{1} << (level * LEVEL_BITS)) - 1)) == 0) {
+            Cascade(level, (now_ >> (level * LEVEL_BITS)) & (SLOT_NUM - 1));
+        }
+    }
+
+    Timer* timer = slots_[0][now_ & (SLOT_NUM - 1)];
+    slots_[0][now_ & (SLOT_NUM - 1)] = nullptr;
+    while (timer != nullptr) {
+        Timer* next = timer->next;
+        timer->prev = nullptr;
+        timer->next = nullptr;
+        expired_.push_back(timer);
+        timer = next;
+    }
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+// Hierarchical timing wheel with LEVEL_NUM levels of SLOT_NUM slots, counted in abstract ticks.
+// A timer sits in the level of the highest 6-bit group in which its expiry differs from the
+// current tick. Whenever the current tick crosses a slot boundary of a higher level, that slot is
+// cascaded into the lower levels; level 0 slots hold timers due exactly at that tick. Timers too
+// far away for the top level wait in an overflow list that is re-placed once per top-level turn.
+// Add and Cancel are O(1); Advance costs O(1) per elapsed tick plus O(1) per cascaded timer.
+// Not thread-safe, the owner serializes access.
+class TimingWheel {
+   public:
+    using TimerId = uint64_t;
+    using Callback = std::function<void()>;
+
+    static constexpr size_t LEVEL_BITS = 6;
+    static constexpr size_t SLOT_NUM = size_t{1} << LEVEL_BITS;
+    static constexpr size_t LEVEL_NUM = 4;
+    static constexpr TimerId INVALID_TIMER = 0;
+
+   public:
+    explicit TimingWheel(uint64_t now = 0) : now_(now) {}
+    ~TimingWheel();
+    TimingWheel(const TimingWheel&) = delete;
+    TimingWheel& operator=(const TimingWheel&) = delete;
+
+    // Schedule callback at tick expire (run on the next tick if expire is not in the future),
+    // then every period ticks if period is not 0.
+    TimerId Add(uint64_t expire, uint64_t period, Callback callback);
+    bool Cancel(TimerId id);
+
+    // Move the wheel to tick now and hand every timer that became due to due(Callback).
+    // One-shot callbacks are moved out, periodic ones are copied and the timer is re-armed.
+    template <typename F>
+    void Advance(uint64_t now, F&& due);
+
+    // Earliest tick at which Advance may have something to do; never later than the next
+    // level-0 turn, so sleeping until this tick never misses a cascade.
+    uint64_t NextTick() const;
+    uint64_t Now() const {
+        return now_;
+    }
+    size_t Size() const {
+        return timers_.size();
+    }
+    bool Empty() const {
+        return timers_.empty();
+    }
+
+   private:
+    static constexpr size_t OVERFLOW_LEVEL = LEVEL_NUM;
+
+    struct Timer {
+        TimerId id;
+        uint64_t expire;
+        uint64_t period;
+        Callback callback;
+        Timer* prev{nullptr};
+        Timer* next{nullptr};
+        size_t level{0};
+        size_t slot{0};
+    };
+
+    void Place(Timer* timer);
+    void Link(Timer* timer, size_t level, size_t slot);
+    void Unlink(Timer* timer);
+    Timer*& Head(size_t level, size_t slot);
+    void Cascade(size_t level, size_t slot);
+    void Tick();
+
+   private:
+    uint64_t now_;
+    TimerId nextId_{INVALID_TIMER + 1};
+    std::array<std::array<Timer*, SLOT_NUM>, LEVEL_NUM> slots_{};
+    Timer* overflow_{nullptr};
+    std::unordered_map<TimerId, Timer*> timers_;
+    std::vector<Timer*> expired_;
+};
+
+template <typename F>
+void TimingWheel::Advance(uint64_t now, F&& due) {
+    if (timers_.empty() && now > now_) {
+        now_ = now;
+        return;
+    }
+
+    while (now_ < now) {
+        Tick();
+        for (Timer* timer : expired_) {
+            if (timer == nullptr) {
+                continue;
+            }
+            if (timer->period == 0) {
+                timers_.erase(timer->id);
+                Callback callback = std::move(timer->callback);
+                delete timer;
+                due(std::move(callback));
+            } else {
+                timer->expire += timer->period;
+                Place(timer);
+                due(Callback(timer->callback));
+            }
+        }
+        expired_.clear();
+    }
+}
@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "fsm/fsm_executor.h"
+
+enum class DoorState : uint32_t { CLOSED, OPEN };
+enum class DoorEvent : uint32_t { OPEN, CLOSE, KNOCK };
+
+// Counts handled events and flags any overlap between two workers on the same actor.
+class CountingDispatcher {
+   public:
+    CountingDispatcher(std::atomic<int>* inFlight, std::atomic<bool>* overlapped, std::atomic<int>* handled)
+        : inFlight_(inFlight), overlapped_(overlapped), handled_(handled) {}
+    bool Dispatch(DoorState state, DoorEvent event, DoorState& toState) {
+        if (inFlight_->fetch_add(1) != 0) {
+            overlapped_->store(true);
+        }
+        handled_->fetch_add(1);
+        bool changed = false;
+        if (state == DoorState::CLOSED && event == DoorEvent::OPEN) {
+            toState = DoorState::OPEN;
+            changed = true;
+        } else if (state == DoorState::OPEN && event == DoorEvent::CLOSE) {
+            toState = DoorState::CLOSED;
+            changed = true;
+        }
+        inFlight_->fetch_sub(1);
+        return changed;
+    }
+
+   private:
+    std::atomic<int>* inFlight_;
+    std::atomic<bool>* overlapped_;
+    std::atomic<int>* handled_;
+};
+
+using DoorActor = FsmActor<DoorState, DoorEvent, CountingDispatcher>;
+
+StateChangeTable<DoorState, DoorEvent> g_doorChangeTable{
+    {DoorState::CLOSED, {{DoorEvent::OPEN, DoorState::OPEN}}},
+    {DoorState::OPEN, {{DoorEvent::CLOSE, DoorState::CLOSED}}},
+};
+
+TEST(FsmExecutorUt, SubmitWithTables) {
+    FsmExecutor executor(2);
+    FsmActor<DoorState, DoorEvent> door(executor, nullptr, &g_doorChangeTable, DoorState::CLOSED);
+    door.Submit(DoorEvent::OPEN).wait();
+    EXPECT_EQ(door.GetState(), DoorState::OPEN);
+    door.Post(DoorEvent::KNOCK);
+    door.Submit(DoorEvent::CLOSE).wait();
+    EXPECT_EQ(door.GetState(), DoorState::CLOSED);
+}
+
+TEST(FsmExecutorUt, ExecutorSize) {
+    FsmExecutor executor(3);
+    EXPECT_EQ(executor.Size(), 3);
+    FsmExecutor fallback(0);
+    EXPECT_EQ(fallback.Size(), 1);
+}
+
+// Without pooled handle blocks every handle comes from the heap.
+TEST(FsmExecutorUt, NoHandlePool) {
+    FsmExecutor executor(2, 0);
+    FsmActor<DoorState, DoorEvent> door(executor, nullptr, &g_doorChangeTable, DoorState::CLOSED);
+    door.Post(DoorEvent::OPEN);
+    door.Submit(DoorEvent::KNOCK).wait();
+    EXPECT_EQ(door.GetState(), DoorState::OPEN);
+}
+
+TEST(FsmExecutorUt, ManyActorsFewThreads) {
+    constexpr size_t ACTOR_NUM = 10000;
+    FsmExecutor executor(4);
+    std::atomic<int> handled{0};
+    std::atomic<bool> overlapped{false};
+    std::vector<std::unique_ptr<std::atomic<int>>> inFlight;
+    std::vector<std::unique_ptr<DoorActor>> actors;
+    for (size_t i = 0; i < ACTOR_NUM; i++) {
+        inFlight.push_back(std::make_unique<std::atomic<int>>(0));
+        actors.push_back(std::make_unique<DoorActor>(
+            executor, CountingDispatcher(inFlight.back().get(), &overlapped, &handled), DoorState::CLOSED));
+    }
+
+    for (auto& actor : actors) {
+        actor->Post(DoorEvent::OPEN);
+    }
+    std::vector<std::future<void>> futures;
+    for (auto& actor : actors) {
+        futures.push_back(actor->Submit(DoorEvent::KNOCK));
+    }
+    for (auto& f : futures) {
+        f.wait();
+    }
+
+    EXPECT_EQ(handled.load(), static_cast<int>(ACTOR_NUM * 2));
+    EXPECT_FALSE(overlapped.load());
+    for (auto& actor : actors) {
+        EXPECT_EQ(actor->GetState(), DoorState::OPEN);
+    }
+}
+
+TEST(FsmExecutorUt, SerialPerActorUnderContention) {
+    constexpr int PRODUCER_NUM = 4;
+    constexpr int EVENT_NUM = 10000;
+    FsmExecutor executor(4);
+    std::atomic<int> handled{0};
+    std::atomic<bool> overlapped{false};
+    std::atomic<int> inFlight{0};
+    {
+        DoorActor door(executor, CountingDispatcher(&inFlight, &overlapped, &handled), DoorState::CLOSED);
+        std::vector<std::thread> producers;
+        for (int p = 0; p < PRODUCER_NUM; p++) {
+            producers.emplace_back([&door]() {
+                for (int i = 0; i < EVENT_NUM; i++) {
+                    door.Post(i % 2 == 0 ? DoorEvent::OPEN : DoorEvent::CLOSE);
+                }
+            });
+        }
+        for (auto& producer : producers) {
+            producer.join();
+        }
+    }
+    EXPECT_EQ(handled.load(), PRODUCER_NUM * EVENT_NUM);
+    EXPECT_FALSE(overlapped.load());
+}
+
+TEST(FsmExecutorUt, KeepsOrderPerActor) {
+    FsmExecutor executor(4);
+    std::vector<DoorEvent> seen;
+    struct RecordingDispatcher {
+        std::vector<DoorEvent>* seen;
+        bool Dispatch(DoorState, DoorEvent event, DoorState&) {
+            seen->push_back(event);
+            return false;
+        }
+    };
+    {
+        FsmActor<DoorState, DoorEvent, RecordingDispatcher> door(executor, RecordingDispatcher{&seen},
+                                                                 DoorState::CLOSED);
+        for (int i = 0; i < 1000; i++) {
+            door.Post(static_cast<DoorEvent>(i % 3));
+        }
+    }
+    ASSERT_EQ(seen.size(), 1000);
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_EQ(seen[i], static_cast<DoorEvent>(i % 3));
+    }
+}
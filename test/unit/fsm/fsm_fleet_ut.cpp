@@ -0,0 +1,167 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "fsm/fsm_fleet.h"
+
+enum class ConnState : uint8_t { CLOSED, SYN_SENT, ESTABLISHED, FIN_WAIT };
+enum class ConnEvent : uint8_t { CONNECT, ACK, CLOSE, RESET };
+
+constexpr size_t CONN_STATE_NUM = 4;
+constexpr size_t CONN_EVENT_NUM = 4;
+using ConnFleet = FsmFleet<ConnState, ConnEvent, CONN_STATE_NUM, CONN_EVENT_NUM>;
+
+class FsmFleetUt : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        transitions_ = {
+            {ConnState::CLOSED, {{ConnEvent::CONNECT, ConnState::SYN_SENT}}},
+            {ConnState::SYN_SENT, {{ConnEvent::ACK, ConnState::ESTABLISHED}, {ConnEvent::RESET, ConnState::CLOSED}}},
+            {ConnState::ESTABLISHED, {{ConnEvent::CLOSE, ConnState::FIN_WAIT}, {ConnEvent::RESET, ConnState::CLOSED}}},
+            {ConnState::FIN_WAIT, {{ConnEvent::ACK, ConnState::CLOSED}}},
+        };
+    }
+
+    StateChangeTable<ConnState, ConnEvent> transitions_;
+};
+
+TEST_F(FsmFleetUt, DispatchSingle) {
+    ConnFleet fleet(nullptr, &transitions_, 2, ConnState::CLOSED);
+    EXPECT_TRUE(fleet.Dispatch(1, ConnEvent::CONNECT));
+    EXPECT_FALSE(fleet.Dispatch(1, ConnEvent::CLOSE));
+    EXPECT_EQ(fleet.GetState(0), ConnState::CLOSED);
+    EXPECT_EQ(fleet.GetState(1), ConnState::SYN_SENT);
+}
+
+TEST_F(FsmFleetUt, DispatchBatchInOrder) {
+    ConnFleet fleet(nullptr, &transitions_, 3, ConnState::CLOSED);
+    std::vector<uint32_t> ids{0, 1, 0, 0, 2, 0, 2};
+    std::vector<ConnEvent> events{ConnEvent::CONNECT, ConnEvent::ACK,   ConnEvent::ACK,  ConnEvent::CLOSE,
+                                  ConnEvent::CONNECT, ConnEvent::RESET, ConnEvent::RESET};
+    EXPECT_EQ(fleet.Dispatch(ids.data(), events.data(), ids.size()), 5);
+    EXPECT_EQ(fleet.GetState(0), ConnState::FIN_WAIT);
+    EXPECT_EQ(fleet.GetState(1), ConnState::CLOSED);
+    EXPECT_EQ(fleet.GetState(2), ConnState::CLOSED);
+}
+
+TEST_F(FsmFleetUt, SkipsUnknownIdsAndEvents) {
+    ConnFleet fleet(nullptr, &transitions_, 1, ConnState::CLOSED);
+    std::vector<uint32_t> ids{5, 0, 0};
+    std::vector<ConnEvent> events{ConnEvent::CONNECT, static_cast<ConnEvent>(CONN_EVENT_NUM), ConnEvent::CONNECT};
+    EXPECT_EQ(fleet.Dispatch(ids.data(), events.data(), ids.size()), 1);
+    EXPECT_EQ(fleet.GetState(0), ConnState::SYN_SENT);
+}
+
+TEST_F(FsmFleetUt, AddAndResize) {
+    ConnFleet fleet(nullptr, &transitions_);
+    EXPECT_EQ(fleet.Size(), 0);
+    EXPECT_EQ(fleet.Add(ConnState::ESTABLISHED), 0);
+    EXPECT_EQ(fleet.Add(ConnState::CLOSED), 1);
+    EXPECT_TRUE(fleet.Resize(1000, ConnState::SYN_SENT));
+    EXPECT_EQ(fleet.Size(), 1000);
+    EXPECT_EQ(fleet.States()[0], ConnState::ESTABLISHED);
+    EXPECT_EQ(fleet.States()[999], ConnState::SYN_SENT);
+}
+
+TEST_F(FsmFleetUt, RejectsStatesOutOfRange) {
+    const ConnState bad = static_cast<ConnState>(CONN_STATE_NUM);
+    ConnFleet empty(nullptr, &transitions_, 4, bad);
+    EXPECT_EQ(empty.Size(), 0);
+
+    ConnFleet fleet(nullptr, &transitions_, 2, ConnState::ESTABLISHED);
+    EXPECT_EQ(fleet.Add(bad), ConnFleet::INVALID_ID);
+    EXPECT_FALSE(fleet.Resize(8, bad));
+    ASSERT_EQ(fleet.Size(), 2);
+    std::vector<uint32_t> ids{0, 1};
+    std::vector<ConnEvent> events{ConnEvent::CLOSE, ConnEvent::RESET};
+    EXPECT_EQ(fleet.Dispatch(ids.data(), events.data(), ids.size()), 2);
+    EXPECT_EQ(fleet.GetState(0), ConnState::FIN_WAIT);
+    EXPECT_EQ(fleet.GetState(1), ConnState::CLOSED);
+}
+
+TEST_F(FsmFleetUt, ActionsMatchDispatcher) {
+    std::vector<std::pair<const char*, ConnState>> log;
+    auto logger = [&log](const char* what, ConnState state) {
+        return [&log, what, state](ConnEvent) { log.emplace_back(what, state); };
+    };
+    StateTable<ConnState, ConnEvent> states{
+        {ConnState::CLOSED, {nullptr, logger("exit", ConnState::CLOSED), logger("callback", ConnState::CLOSED)}},
+        {ConnState::SYN_SENT, {logger("entry", ConnState::SYN_SENT), nullptr, nullptr}},
+    };
+    ConnFleet fleet(&states, &transitions_, 1, ConnState::CLOSED);
+    std::vector<uint32_t> ids{0, 0};
+    std::vector<ConnEvent> events{ConnEvent::CLOSE, ConnEvent::CONNECT};
+    EXPECT_EQ(fleet.Dispatch(ids.data(), events.data(), ids.size()), 1);
+    EXPECT_EQ(fleet.GetState(0), ConnState::SYN_SENT);
+    std::vector<std::pair<const char*, ConnState>> expected{{"callback", ConnState::CLOSED},
+                                                            {"callback", ConnState::CLOSED},
+                                                            {"exit", ConnState::CLOSED},
+                                                            {"entry", ConnState::SYN_SENT}};
+    EXPECT_EQ(log, expected);
+}
+
+TEST_F(FsmFleetUt, ManyMachines) {
+    constexpr size_t FLEET_SIZE = 1 << 20;
+    ConnFleet fleet(nullptr, &transitions_, FLEET_SIZE, ConnState::CLOSED);
+    std::vector<uint32_t> ids(FLEET_SIZE);
+    std::vector<ConnEvent> events(FLEET_SIZE, ConnEvent::CONNECT);
+    for (size_t i = 0; i < FLEET_SIZE; i++) {
+        ids[i] = static_cast<uint32_t>(i);
+    }
+    EXPECT_EQ(fleet.Dispatch(ids.data(), events.data(), ids.size()), FLEET_SIZE);
+    std::fill(events.begin(), events.end(), ConnEvent::ACK);
+    EXPECT_EQ(fleet.Dispatch(ids.data(), events.data(), ids.size() / 2), FLEET_SIZE / 2);
+    EXPECT_EQ(fleet.GetState(0), ConnState::ESTABLISHED);
+    EXPECT_EQ(fleet.GetState(FLEET_SIZE - 1), ConnState::SYN_SENT);
+}
+
+TEST_F(FsmFleetUt, SnapshotRoundTrip) {
+    ConnFleet fleet(nullptr, &transitions_, 3, ConnState::CLOSED);
+    fleet.Dispatch(1, ConnEvent::CONNECT);
+    fleet.Dispatch(2, ConnEvent::CONNECT);
+    fleet.Dispatch(2, ConnEvent::ACK);
+    std::vector<uint8_t> blob = fleet.Snapshot();
+
+    ConnFleet restored(nullptr, &transitions_);
+    ASSERT_TRUE(restored.Restore(blob.data(), blob.size()));
+    ASSERT_EQ(restored.Size(), 3);
+    EXPECT_EQ(restored.GetState(0), ConnState::CLOSED);
+    EXPECT_EQ(restored.GetState(1), ConnState::SYN_SENT);
+    EXPECT_EQ(restored.GetState(2), ConnState::ESTABLISHED);
+}
+
+TEST_F(FsmFleetUt, RestoreRejectsMismatch) {
+    ConnFleet fleet(nullptr, &transitions_, 2, ConnState::CLOSED);
+    std::vector<uint8_t> blob = fleet.Snapshot();
+
+    FsmFleet<ConnState, ConnEvent, CONN_STATE_NUM + 1, CONN_EVENT_NUM> bigger(nullptr, &transitions_);
+    EXPECT_FALSE(bigger.Restore(blob.data(), blob.size()));
+
+    ConnFleet restored(nullptr, &transitions_, 1, ConnState::FIN_WAIT);
+    EXPECT_FALSE(restored.Restore(blob.data(), blob.size() - 1));
+    blob.back() = static_cast<uint8_t>(CONN_STATE_NUM);
+    EXPECT_FALSE(restored.Restore(blob.data(), blob.size()));
+    ASSERT_EQ(restored.Size(), 1);
+    EXPECT_EQ(restored.GetState(0), ConnState::FIN_WAIT);
+}
+
+TEST_F(FsmFleetUt, SnapshotFile) {
+    std::string path = ::testing::TempDir() + "fsm_fleet_ut.snapshot";
+    ConnFleet fleet(nullptr, &transitions_, 100000, ConnState::CLOSED);
+    for (uint32_t id = 0; id < fleet.Size(); id += 3) {
+        fleet.Dispatch(id, ConnEvent::CONNECT);
+    }
+    ASSERT_TRUE(fleet.SaveSnapshot(path));
+
+    ConnFleet restored(nullptr, &transitions_);
+    ASSERT_TRUE(restored.LoadSnapshot(path));
+    ASSERT_EQ(restored.Size(), fleet.Size());
+    EXPECT_EQ(std::memcmp(restored.States(), fleet.States(), fleet.Size() * sizeof(ConnState)), 0);
+    EXPECT_FALSE(restored.LoadSnapshot(path + ".missing"));
+    std::remove(path.c_str());
+}
@@ -2,6 +2,7 @@
 
 #include <atomic>
 #include <mutex>
+#include <thread>
 #include <vector>
 
 #include "fsm/fsm.h"
@@ -186,3 +187,342 @@ TEST_F(FsmUt, InvalidTransition_CallbackStillCalled) {
     EXPECT_EQ(g_callbacks.exitCount, 0);
     EXPECT_EQ(g_callbacks.entryCount, 0);
 }
+
+constexpr size_t PLAYER_STATE_NUM = 5;
+constexpr size_t PLAYER_EVENT_NUM = 5;
+using PlayerDenseChangeTable = FsmDenseChangeTable<PlayerState, PlayerEvent, PLAYER_STATE_NUM, PLAYER_EVENT_NUM>;
+using PlayerDenseStateTable = FsmDenseStateTable<PlayerState, PlayerEvent, PLAYER_STATE_NUM>;
+using PlayerDenseDispatcher = FsmDispatcher<PlayerState, PlayerEvent, PlayerDenseStateTable, PlayerDenseChangeTable>;
+
+constexpr PlayerDenseChangeTable g_playerDenseChangeTable{
+    {PlayerState::RAW, PlayerEvent::INIT, PlayerState::INIT},
+    {PlayerState::INIT, PlayerEvent::DESTROY, PlayerState::RAW},
+    {PlayerState::INIT, PlayerEvent::PLAY, PlayerState::PLAY},
+    {PlayerState::PLAY, PlayerEvent::PAUSE, PlayerState::PAUSE},
+    {PlayerState::PAUSE, PlayerEvent::PLAY, PlayerState::PLAY},
+};
+static_assert(g_playerDenseChangeTable.Valid(PlayerState::RAW, PlayerEvent::INIT));
+static_assert(!g_playerDenseChangeTable.Valid(PlayerState::RAW, PlayerEvent::PLAY));
+
+TEST_F(FsmUt, DenseChangeTableMatchesMap) {
+    PlayerDenseChangeTable dense(&g_playerStateChangeTable);
+    FsmStateChangeTable<PlayerState, PlayerEvent> sparse(&g_playerStateChangeTable);
+    for (size_t s = 0; s < PLAYER_STATE_NUM; s++) {
+        for (size_t e = 0; e < PLAYER_EVENT_NUM; e++) {
+            PlayerState denseTo = PlayerState::RAW;
+            PlayerState sparseTo = PlayerState::RAW;
+            bool denseFound = dense.GetTostate(static_cast<PlayerState>(s), static_cast<PlayerEvent>(e), denseTo);
+            bool sparseFound = sparse.GetTostate(static_cast<PlayerState>(s), static_cast<PlayerEvent>(e), sparseTo);
+            EXPECT_EQ(denseFound, sparseFound);
+            EXPECT_EQ(denseTo, sparseTo);
+        }
+    }
+}
+
+TEST_F(FsmUt, DenseChangeTableOutOfRange) {
+    PlayerState toState = PlayerState::RAW;
+    EXPECT_FALSE(g_playerDenseChangeTable.GetTostate(static_cast<PlayerState>(PLAYER_STATE_NUM), PlayerEvent::INIT,
+                                                     toState));
+    EXPECT_FALSE(g_playerDenseChangeTable.GetTostate(PlayerState::RAW, static_cast<PlayerEvent>(PLAYER_EVENT_NUM),
+                                                     toState));
+}
+
+TEST_F(FsmUt, DenseTables) {
+    FSM<PlayerState, PlayerEvent, PlayerDenseDispatcher> player(
+        PlayerDenseDispatcher(PlayerDenseStateTable(&g_playerStateTable), g_playerDenseChangeTable), PlayerState::RAW);
+    player.Submit(PlayerEvent::INIT).wait();
+    player.Submit(PlayerEvent::PLAY).wait();
+    player.Submit(PlayerEvent::STOP).wait();
+    EXPECT_EQ(player.GetState(), PlayerState::PLAY);
+    player.Submit(PlayerEvent::PAUSE).wait();
+    EXPECT_EQ(player.GetState(), PlayerState::PAUSE);
+
+    EXPECT_EQ(g_callbacks.entryCount, 3);
+    EXPECT_EQ(g_callbacks.exitCount, 3);
+    EXPECT_EQ(g_callbacks.callbackCount, 4 + 3);
+}
+
+TEST_F(FsmUt, DenseTablesFromMaps) {
+    FSM<PlayerState, PlayerEvent, PlayerDenseDispatcher> player(&g_playerStateTable, &g_playerStateChangeTable,
+                                                                PlayerState::RAW);
+    player.Submit(PlayerEvent::INIT).wait();
+    player.Submit(PlayerEvent::STOP).wait();
+    player.Submit(PlayerEvent::PAUSE).wait();
+    EXPECT_EQ(player.GetState(), PlayerState::STOP);
+}
+
+TEST_F(FsmUt, DenseStateTableSkipsMissingActions) {
+    StateTable<PlayerState, PlayerEvent> partial{{PlayerState::INIT, {g_callbacks.Entry(), nullptr, nullptr}}};
+    PlayerDenseStateTable table(&partial);
+    table.Exit(PlayerState::INIT, PlayerEvent::INIT);
+    table.Callback(PlayerState::RAW, PlayerEvent::INIT);
+    table.Entry(PlayerState::INIT, PlayerEvent::INIT);
+    EXPECT_EQ(g_callbacks.entryCount, 1);
+}
+
+TEST_F(FsmUt, PauseResume) {
+    FSM<PlayerState, PlayerEvent> player(&g_playerStateTable, &g_playerStateChangeTable, PlayerState::RAW);
+    player.Pause();
+    EXPECT_TRUE(player.Paused());
+    std::future<void> done = player.Submit(PlayerEvent::INIT);
+    EXPECT_EQ(done.wait_for(std::chrono::milliseconds(20)), std::future_status::timeout);
+    EXPECT_EQ(player.GetState(), PlayerState::RAW);
+
+    player.Resume();
+    EXPECT_FALSE(player.Paused());
+    done.wait();
+    EXPECT_EQ(player.GetState(), PlayerState::INIT);
+}
+
+TEST_F(FsmUt, DestroyWhilePaused) {
+    std::future<void> done;
+    {
+        FSM<PlayerState, PlayerEvent> player(&g_playerStateTable, &g_playerStateChangeTable, PlayerState::RAW);
+        player.Pause();
+        done = player.Submit(PlayerEvent::INIT);
+    }
+    EXPECT_EQ(g_callbacks.entryCount, 0);
+}
+
+TEST_F(FsmUt, Post) {
+    FSM<PlayerState, PlayerEvent> player(&g_playerStateTable, &g_playerStateChangeTable, PlayerState::RAW);
+    player.Post(PlayerEvent::INIT);
+    player.Post(PlayerEvent::PLAY);
+    player.Submit(PlayerEvent::PAUSE).wait();
+    EXPECT_EQ(player.GetState(), PlayerState::PAUSE);
+    EXPECT_EQ(g_callbacks.entryCount, 3);
+}
+
+TEST_F(FsmUt, SubmitBatch) {
+    FSM<PlayerState, PlayerEvent> player(&g_playerStateTable, &g_playerStateChangeTable, PlayerState::RAW);
+    std::vector<PlayerEvent> events;
+    for (int i = 0; i < 1000; i++) {
+        events.push_back(PlayerEvent::INIT);
+        events.push_back(PlayerEvent::DESTROY);
+    }
+    events.push_back(PlayerEvent::INIT);
+    player.SubmitBatch(events).wait();
+    EXPECT_EQ(player.GetState(), PlayerState::INIT);
+    EXPECT_EQ(g_callbacks.entryCount, 2001);
+}
+
+TEST_F(FsmUt, SubmitBatchEmpty) {
+    FSM<PlayerState, PlayerEvent> player(&g_playerStateTable, &g_playerStateChangeTable, PlayerState::RAW);
+    std::future<void> done = player.SubmitBatch(nullptr, 0);
+    EXPECT_EQ(done.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+}
+
+TEST_F(FsmUt, SubmitBatchWhilePaused) {
+    FSM<PlayerState, PlayerEvent> player(&g_playerStateTable, &g_playerStateChangeTable, PlayerState::RAW);
+    player.Pause();
+    const PlayerEvent events[] = {PlayerEvent::INIT, PlayerEvent::PLAY};
+    std::future<void> done = player.SubmitBatch(events, 2);
+    EXPECT_EQ(done.wait_for(std::chrono::milliseconds(20)), std::future_status::timeout);
+    player.Resume();
+    done.wait();
+    EXPECT_EQ(player.GetState(), PlayerState::PLAY);
+}
+
+// More events in flight than the handle pool holds: the rest come from the heap, and pooled
+// handles are reused once the first round is done.
+TEST_F(FsmUt, HandlePoolOverflow) {
+    constexpr size_t POOL_SIZE = 8;
+    FSM<PlayerState, PlayerEvent> player(&g_playerStateTable, &g_playerStateChangeTable, PlayerState::RAW, POOL_SIZE);
+    for (int round = 0; round < 2; round++) {
+        player.Pause();
+        std::vector<std::future<void>> done;
+        for (size_t i = 0; i < 4 * POOL_SIZE; i++) {
+            done.push_back(player.Submit(PlayerEvent::INIT));
+            done.push_back(player.Submit(PlayerEvent::DESTROY));
+        }
+        player.Resume();
+        for (std::future<void>& f : done) {
+            f.wait();
+        }
+        EXPECT_EQ(player.GetState(), PlayerState::RAW);
+    }
+    EXPECT_EQ(g_callbacks.entryCount, 16 * POOL_SIZE);
+}
+
+using PlayerStaticChangeTable =
+    FsmStaticChangeTable<FsmStaticTransition<PlayerState::RAW, PlayerEvent::INIT, PlayerState::INIT>,
+                         FsmStaticTransition<PlayerState::INIT, PlayerEvent::PLAY, PlayerState::PLAY>,
+                         FsmStaticTransition<PlayerState::PLAY, PlayerEvent::PAUSE, PlayerState::PAUSE>,
+                         FsmStaticTransition<PlayerState::PAUSE, PlayerEvent::PLAY, PlayerState::PLAY>>;
+static_assert(PlayerStaticChangeTable().Valid(PlayerState::PLAY, PlayerEvent::PAUSE));
+static_assert(!PlayerStaticChangeTable().Valid(PlayerState::RAW, PlayerEvent::PLAY));
+
+struct CountingAction {
+    int* count;
+    void operator()(PlayerEvent) const {
+        (*count)++;
+    }
+};
+
+TEST_F(FsmUt, StaticTablesInline) {
+    int entries = 0;
+    int exits = 0;
+    int callbacks = 0;
+    CountingAction entry{&entries};
+    CountingAction exit{&exits};
+    CountingAction callback{&callbacks};
+    FsmStaticStateTable stateTable{MakeFsmState<PlayerState::RAW>(entry, exit, callback),
+                                   MakeFsmState<PlayerState::INIT>(entry, exit, callback),
+                                   MakeFsmState<PlayerState::PLAY>(entry, exit, callback),
+                                   MakeFsmState<PlayerState::PAUSE>(entry, exit, callback)};
+    auto dispatcher = MakeFsmDispatcher<PlayerState, PlayerEvent>(stateTable, PlayerStaticChangeTable());
+    FsmInline<PlayerState, PlayerEvent, decltype(dispatcher)> player(dispatcher, PlayerState::RAW);
+
+    EXPECT_TRUE(player.Dispatch(PlayerEvent::INIT));
+    EXPECT_TRUE(player.Dispatch(PlayerEvent::PLAY));
+    EXPECT_FALSE(player.Dispatch(PlayerEvent::STOP));
+    EXPECT_TRUE(player.Dispatch(PlayerEvent::PAUSE));
+    EXPECT_EQ(player.GetState(), PlayerState::PAUSE);
+    EXPECT_EQ(entries, 3);
+    EXPECT_EQ(exits, 3);
+    EXPECT_EQ(callbacks, 4 + 3);
+}
+
+TEST_F(FsmUt, StaticTablesMissingState) {
+    int entries = 0;
+    FsmStaticStateTable stateTable{MakeFsmState<PlayerState::INIT>(CountingAction{&entries})};
+    auto dispatcher = MakeFsmDispatcher<PlayerState, PlayerEvent>(stateTable, PlayerStaticChangeTable());
+    FsmInline<PlayerState, PlayerEvent, decltype(dispatcher)> player(dispatcher, PlayerState::RAW);
+    player.Dispatch(PlayerEvent::INIT);
+    player.Dispatch(PlayerEvent::PLAY);
+    EXPECT_EQ(player.GetState(), PlayerState::PLAY);
+    EXPECT_EQ(entries, 1);
+}
+
+TEST_F(FsmUt, StaticTablesOnProcessor) {
+    auto dispatcher = MakeFsmDispatcher<PlayerState, PlayerEvent>(
+        FsmStaticStateTable{MakeFsmState<PlayerState::INIT>(g_callbacks.Entry(), g_callbacks.Exit())},
+        PlayerStaticChangeTable());
+    FSM<PlayerState, PlayerEvent, decltype(dispatcher)> player(dispatcher, PlayerState::RAW);
+    player.Submit(PlayerEvent::INIT).wait();
+    player.Submit(PlayerEvent::PLAY).wait();
+    EXPECT_EQ(player.GetState(), PlayerState::PLAY);
+    EXPECT_EQ(g_callbacks.entryCount, 1);
+    EXPECT_EQ(g_callbacks.exitCount, 1);
+}
+
+TEST_F(FsmUt, InlineWithMapTables) {
+    FsmInline<PlayerState, PlayerEvent> player(&g_playerStateTable, &g_playerStateChangeTable, PlayerState::RAW);
+    player.Dispatch(PlayerEvent::INIT);
+    player.Dispatch(PlayerEvent::STOP);
+    EXPECT_EQ(player.GetState(), PlayerState::STOP);
+    EXPECT_EQ(g_callbacks.entryCount, 2);
+}
+
+TEST_F(FsmUt, Tracer) {
+    FsmTracer<PlayerState, PlayerEvent> tracer(PLAYER_STATE_NUM, PLAYER_EVENT_NUM, 4);
+    FSM<PlayerState, PlayerEvent> player(&g_playerStateTable, &g_playerStateChangeTable, PlayerState::RAW);
+    player.SetTracer(&tracer);
+    player.Post(PlayerEvent::INIT);
+    player.Post(PlayerEvent::PLAY);
+    player.Post(PlayerEvent::INIT);
+    player.Post(PlayerEvent::PAUSE);
+    player.Submit(PlayerEvent::PLAY).wait();
+
+    EXPECT_EQ(tracer.Recorded(), 5);
+    std::vector<FsmTraceRecord<PlayerState, PlayerEvent>> records = tracer.Recent();
+    ASSERT_EQ(records.size(), 4);
+    EXPECT_EQ(records[0].from, PlayerState::INIT);
+    EXPECT_EQ(records[0].event, PlayerEvent::PLAY);
+    EXPECT_EQ(records[0].to, PlayerState::PLAY);
+    EXPECT_EQ(records[1].from, PlayerState::PLAY);
+    EXPECT_EQ(records[1].to, PlayerState::PLAY);
+    EXPECT_EQ(records[3].from, PlayerState::PAUSE);
+    EXPECT_EQ(records[3].to, PlayerState::PLAY);
+    for (size_t i = 1; i < records.size(); i++) {
+        EXPECT_GE(records[i].timestampNs, records[i - 1].timestampNs);
+    }
+
+    EXPECT_EQ(tracer.ActionTime(PlayerState::RAW, PlayerEvent::INIT).count, 1);
+    EXPECT_EQ(tracer.ActionTime(PlayerState::PLAY, PlayerEvent::INIT).count, 1);
+    EXPECT_EQ(tracer.DwellTime(PlayerState::INIT).count, 1);
+    EXPECT_EQ(tracer.DwellTime(PlayerState::PLAY).count, 1);
+    EXPECT_EQ(tracer.DwellTime(PlayerState::PAUSE).count, 1);
+    EXPECT_EQ(tracer.DwellTime(PlayerState::STOP).count, 0);
+
+    player.SetTracer(nullptr);
+    player.Submit(PlayerEvent::STOP).wait();
+    EXPECT_EQ(tracer.Recorded(), 5);
+}
+
+TEST_F(FsmUt, TracerSlowAction) {
+    Action<PlayerEvent> noop = [](PlayerEvent) {};
+    StateTable<PlayerState, PlayerEvent> slow{
+        {PlayerState::RAW, {noop, noop, noop}},
+        {PlayerState::INIT,
+         {[](PlayerEvent) { std::this_thread::sleep_for(std::chrono::milliseconds(2)); }, noop, noop}}};
+    FsmTracer<PlayerState, PlayerEvent> tracer(PLAYER_STATE_NUM, PLAYER_EVENT_NUM);
+    FSM<PlayerState, PlayerEvent> player(&slow, &g_playerStateChangeTable, PlayerState::RAW);
+    player.SetTracer(&tracer);
+    player.Submit(PlayerEvent::INIT).wait();
+    EXPECT_GE(tracer.ActionTime(PlayerState::RAW, PlayerEvent::INIT).max, 2000000u);
+}
+
+// Dwell runs from the end of the transition into a state to the end of the one out of it.
+TEST_F(FsmUt, TracerDwellFromEntry) {
+    FsmTracer<PlayerState, PlayerEvent> tracer(PLAYER_STATE_NUM, PLAYER_EVENT_NUM);
+    tracer.Record(PlayerState::RAW, PlayerEvent::PLAY, PlayerState::RAW, 100, 200);
+    tracer.Record(PlayerState::RAW, PlayerEvent::INIT, PlayerState::INIT, 1000, 1500);
+    tracer.Record(PlayerState::INIT, PlayerEvent::DESTROY, PlayerState::INIT, 2000, 2100);
+    tracer.Record(PlayerState::INIT, PlayerEvent::PLAY, PlayerState::PLAY, 3000, 3200);
+    EXPECT_EQ(tracer.DwellTime(PlayerState::RAW).count, 0);
+    EXPECT_EQ(tracer.DwellTime(PlayerState::INIT).count, 1);
+    EXPECT_EQ(tracer.DwellTime(PlayerState::INIT).max, 1700u);
+}
+
+TEST_F(FsmUt, SnapshotIdle) {
+    FSM<PlayerState, PlayerEvent> player(&g_playerStateTable, &g_playerStateChangeTable, PlayerState::RAW);
+    player.Submit(PlayerEvent::INIT).wait();
+    FsmSnapshot<PlayerState, PlayerEvent> snapshot = player.Snapshot().get();
+    EXPECT_EQ(snapshot.state, PlayerState::INIT);
+    EXPECT_TRUE(snapshot.pending.empty());
+}
+
+TEST_F(FsmUt, SnapshotWhilePaused) {
+    FSM<PlayerState, PlayerEvent> player(&g_playerStateTable, &g_playerStateChangeTable, PlayerState::RAW);
+    player.Submit(PlayerEvent::INIT).wait();
+    player.Pause();
+    player.Post(PlayerEvent::PLAY);
+    player.Post(PlayerEvent::PAUSE);
+    FsmSnapshot<PlayerState, PlayerEvent> snapshot = player.Snapshot().get();
+    EXPECT_EQ(snapshot.state, PlayerState::INIT);
+    EXPECT_EQ(snapshot.pending, (std::vector<PlayerEvent>{PlayerEvent::PLAY, PlayerEvent::PAUSE}));
+    EXPECT_EQ(player.GetState(), PlayerState::INIT);
+
+    // The pending events are still handled by the original.
+    player.Resume();
+    player.Submit(PlayerEvent::STOP).wait();
+    EXPECT_EQ(player.GetState(), PlayerState::STOP);
+}
+
+TEST_F(FsmUt, RestoreFromSnapshot) {
+    FsmSnapshot<PlayerState, PlayerEvent> snapshot{PlayerState::INIT, {PlayerEvent::PLAY, PlayerEvent::PAUSE}};
+    std::vector<uint8_t> blob = snapshot.Serialize();
+
+    FsmSnapshot<PlayerState, PlayerEvent> loaded;
+    ASSERT_TRUE(loaded.Deserialize(blob.data(), blob.size()));
+    FSM<PlayerState, PlayerEvent> player(&g_playerStateTable, &g_playerStateChangeTable, loaded);
+    player.Submit(PlayerEvent::STOP).wait();
+    EXPECT_EQ(player.GetState(), PlayerState::STOP);
+    EXPECT_EQ(g_callbacks.entryCount, 3);
+}
+
+TEST_F(FsmUt, SnapshotRejectsBadBlob) {
+    FsmSnapshot<PlayerState, PlayerEvent> snapshot{PlayerState::PLAY, {PlayerEvent::STOP}};
+    std::vector<uint8_t> blob = snapshot.Serialize();
+    FsmSnapshot<PlayerState, PlayerEvent> loaded;
+    EXPECT_FALSE(loaded.Deserialize(blob.data(), blob.size() - 1));
+    EXPECT_FALSE(loaded.Deserialize(blob.data(), 8));
+
+    FsmSnapshot<uint8_t, PlayerEvent> other;
+    EXPECT_FALSE(other.Deserialize(blob.data(), blob.size()));
+
+    blob[0] ^= 0xFF;
+    EXPECT_FALSE(loaded.Deserialize(blob.data(), blob.size()));
+    EXPECT_EQ(loaded.state, PlayerState::RAW);
+}
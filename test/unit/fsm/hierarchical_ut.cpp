@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "fsm/fsm.h"
+#include "fsm/hierarchical.h"
+
+// ONLINE { IDLE, BUSY }, OFFLINE
+enum class LinkState : uint32_t { ONLINE, IDLE, BUSY, OFFLINE };
+enum class LinkEvent : uint32_t { CONNECT, DISCONNECT, WORK, RESET, RETRY, NOOP };
+
+constexpr size_t LINK_STATE_NUM = 4;
+constexpr size_t LINK_EVENT_NUM = 6;
+using LinkDispatcher = FsmHierarchicalDispatcher<LinkState, LinkEvent, LINK_STATE_NUM, LINK_EVENT_NUM>;
+
+class HierarchicalUt : public ::testing::Test {
+   protected:
+    Action<LinkEvent> Log(std::string what) {
+        return [this, what](LinkEvent) { log_.push_back(what); };
+    }
+    FsmState<LinkState, LinkEvent> Actions(const std::string& name) {
+        return {Log("entry " + name), Log("exit " + name), nullptr};
+    }
+
+    void SetUp() override {
+        parents_ = {{LinkState::IDLE, LinkState::ONLINE}, {LinkState::BUSY, LinkState::ONLINE}};
+        states_ = {{LinkState::ONLINE, Actions("online")},
+                   {LinkState::IDLE, Actions("idle")},
+                   {LinkState::BUSY, Actions("busy")},
+                   {LinkState::OFFLINE, Actions("offline")}};
+        transitions_ = {
+            {LinkState::ONLINE,
+             {{LinkEvent::DISCONNECT, LinkState::OFFLINE}, {LinkEvent::RESET, LinkState::IDLE}}},
+            {LinkState::IDLE, {{LinkEvent::WORK, LinkState::BUSY}}},
+            {LinkState::BUSY, {{LinkEvent::RETRY, LinkState::BUSY}, {LinkEvent::RESET, LinkState::ONLINE}}},
+            {LinkState::OFFLINE, {{LinkEvent::CONNECT, LinkState::IDLE}}},
+        };
+    }
+
+    StateParentTable<LinkState> parents_;
+    StateTable<LinkState, LinkEvent> states_;
+    StateChangeTable<LinkState, LinkEvent> transitions_;
+    std::vector<std::string> log_;
+};
+
+TEST_F(HierarchicalUt, SiblingTransitionKeepsParent) {
+    FsmInline<LinkState, LinkEvent, LinkDispatcher> link(LinkDispatcher(&parents_, &states_, &transitions_),
+                                                         LinkState::IDLE);
+    EXPECT_TRUE(link.Dispatch(LinkEvent::WORK));
+    EXPECT_EQ(link.GetState(), LinkState::BUSY);
+    EXPECT_EQ(log_, (std::vector<std::string>{"exit idle", "entry busy"}));
+}
+
+TEST_F(HierarchicalUt, EventBubblesToParent) {
+    FsmInline<LinkState, LinkEvent, LinkDispatcher> link(LinkDispatcher(&parents_, &states_, &transitions_),
+                                                         LinkState::BUSY);
+    EXPECT_TRUE(link.Dispatch(LinkEvent::DISCONNECT));
+    EXPECT_EQ(link.GetState(), LinkState::OFFLINE);
+    EXPECT_EQ(log_, (std::vector<std::string>{"exit busy", "exit online", "entry offline"}));
+}
+
+TEST_F(HierarchicalUt, EnterNestedState) {
+    FsmInline<LinkState, LinkEvent, LinkDispatcher> link(LinkDispatcher(&parents_, &states_, &transitions_),
+                                                         LinkState::OFFLINE);
+    EXPECT_TRUE(link.Dispatch(LinkEvent::CONNECT));
+    EXPECT_EQ(link.GetState(), LinkState::IDLE);
+    EXPECT_EQ(log_, (std::vector<std::string>{"exit offline", "entry online", "entry idle"}));
+}
+
+TEST_F(HierarchicalUt, ParentTargetsOwnChild) {
+    FsmInline<LinkState, LinkEvent, LinkDispatcher> link(LinkDispatcher(&parents_, &states_, &transitions_),
+                                                         LinkState::IDLE);
+    link.Dispatch(LinkEvent::WORK);
+    log_.clear();
+    // BUSY overrides RESET itself, IDLE inherits it from ONLINE.
+    EXPECT_TRUE(link.Dispatch(LinkEvent::RESET));
+    EXPECT_EQ(link.GetState(), LinkState::ONLINE);
+    EXPECT_EQ(log_, (std::vector<std::string>{"exit busy", "exit online", "entry online"}));
+
+    FsmInline<LinkState, LinkEvent, LinkDispatcher> idle(LinkDispatcher(&parents_, &states_, &transitions_),
+                                                         LinkState::IDLE);
+    log_.clear();
+    EXPECT_TRUE(idle.Dispatch(LinkEvent::RESET));
+    EXPECT_EQ(idle.GetState(), LinkState::IDLE);
+    EXPECT_EQ(log_, (std::vector<std::string>{"exit idle", "entry idle"}));
+}
+
+TEST_F(HierarchicalUt, SelfTransition) {
+    FsmInline<LinkState, LinkEvent, LinkDispatcher> link(LinkDispatcher(&parents_, &states_, &transitions_),
+                                                         LinkState::BUSY);
+    EXPECT_TRUE(link.Dispatch(LinkEvent::RETRY));
+    EXPECT_EQ(link.GetState(), LinkState::BUSY);
+    EXPECT_EQ(log_, (std::vector<std::string>{"exit busy", "entry busy"}));
+}
+
+TEST_F(HierarchicalUt, UnhandledEvent) {
+    LinkDispatcher dispatcher(&parents_, &states_, &transitions_);
+    LinkState toState = LinkState::IDLE;
+    EXPECT_FALSE(dispatcher.GetTostate(LinkState::OFFLINE, LinkEvent::WORK, toState));
+    EXPECT_FALSE(dispatcher.GetTostate(LinkState::BUSY, LinkEvent::NOOP, toState));
+    EXPECT_TRUE(dispatcher.GetTostate(LinkState::IDLE, LinkEvent::DISCONNECT, toState));
+    EXPECT_EQ(toState, LinkState::OFFLINE);
+
+    FsmInline<LinkState, LinkEvent, LinkDispatcher> link(dispatcher, LinkState::OFFLINE);
+    EXPECT_FALSE(link.Dispatch(LinkEvent::WORK));
+    EXPECT_TRUE(log_.empty());
+}
+
+TEST_F(HierarchicalUt, OnProcessor) {
+    FSM<LinkState, LinkEvent, LinkDispatcher> link(LinkDispatcher(&parents_, &states_, &transitions_),
+                                                   LinkState::OFFLINE);
+    link.Post(LinkEvent::CONNECT);
+    link.Post(LinkEvent::WORK);
+    link.Submit(LinkEvent::DISCONNECT).wait();
+    EXPECT_EQ(link.GetState(), LinkState::OFFLINE);
+    EXPECT_EQ(log_.size(), 8);
+}
@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+
+#include <future>
+#include <memory>
+#include <vector>
+
+#include "queue/mpsc_queue.h"
+
+struct mpsc_item : mpsc_hook {
+    explicit mpsc_item(uint32_t v = 0, uint32_t p = 0) : value(v), producer(p) {}
+    uint32_t value;
+    uint32_t producer;
+};
+
+TEST(mpsc_queue_ut, init_empty) {
+    mpsc_queue<mpsc_item> queue;
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(queue.try_dequeue(), nullptr);
+}
+
+TEST(mpsc_queue_ut, fifo) {
+    mpsc_queue<mpsc_item> queue;
+    std::vector<mpsc_item> items(8);
+    for (uint32_t i = 0; i < items.size(); i++) {
+        items[i].value = i;
+        EXPECT_TRUE(queue.enqueue(&items[i]));
+    }
+    EXPECT_FALSE(queue.empty());
+    for (uint32_t i = 0; i < items.size(); i++) {
+        mpsc_item* item = queue.try_dequeue();
+        ASSERT_NE(item, nullptr);
+        EXPECT_EQ(item->value, i);
+    }
+    EXPECT_EQ(queue.try_dequeue(), nullptr);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(mpsc_queue_ut, reuse_after_drain) {
+    mpsc_queue<mpsc_item> queue;
+    mpsc_item a(1);
+    mpsc_item b(2);
+    for (int round = 0; round < 3; round++) {
+        queue.enqueue(&a);
+        EXPECT_EQ(queue.try_dequeue(), &a);
+        queue.enqueue(&b);
+        queue.enqueue(&a);
+        EXPECT_EQ(queue.try_dequeue(), &b);
+        EXPECT_EQ(queue.try_dequeue(), &a);
+        EXPECT_EQ(queue.try_dequeue(), nullptr);
+    }
+}
+
+TEST(mpsc_queue_ut, enqueue_bulk) {
+    mpsc_queue<mpsc_item> queue;
+    mpsc_item first(0);
+    queue.enqueue(&first);
+    std::vector<mpsc_item> items(4);
+    std::vector<mpsc_item*> nodes;
+    for (uint32_t i = 0; i < items.size(); i++) {
+        items[i].value = i + 1;
+        nodes.push_back(&items[i]);
+    }
+    EXPECT_TRUE(queue.enqueue_bulk(nodes.data(), nodes.size()));
+    for (uint32_t i = 0; i <= items.size(); i++) {
+        mpsc_item* item = queue.try_dequeue();
+        ASSERT_NE(item, nullptr);
+        EXPECT_EQ(item->value, i);
+    }
+    EXPECT_EQ(queue.try_dequeue(), nullptr);
+}
+
+TEST(mpsc_queue_ut, close) {
+    mpsc_queue<mpsc_item> queue;
+    mpsc_item a(1);
+    mpsc_item b(2);
+    queue.enqueue(&a);
+    queue.close();
+    EXPECT_TRUE(queue.is_closed());
+    EXPECT_FALSE(queue.enqueue(&b));
+    EXPECT_EQ(queue.dequeue(), &a);
+    EXPECT_EQ(queue.dequeue(), nullptr);
+}
+
+TEST(mpsc_queue_ut, dequeue_wakes_on_close) {
+    mpsc_queue<mpsc_item> queue;
+    std::future<mpsc_item*> consumer = std::async(std::launch::async, [&queue]() { return queue.dequeue(); });
+    queue.close();
+    EXPECT_EQ(consumer.get(), nullptr);
+}
+
+TEST(mpsc_queue_ut, multi_in_single_out) {
+    constexpr uint32_t PRODUCER_NUM = 4;
+    constexpr uint32_t ITEM_NUM = 20000;
+    mpsc_queue<mpsc_item> queue;
+    std::vector<std::unique_ptr<mpsc_item[]>> items;
+    for (uint32_t p = 0; p < PRODUCER_NUM; p++) {
+        items.emplace_back(new mpsc_item[ITEM_NUM]);
+    }
+
+    std::future<bool> consumer = std::async(std::launch::async, [&queue]() {
+        std::vector<uint32_t> next(PRODUCER_NUM, 0);
+        for (uint32_t i = 0; i < PRODUCER_NUM * ITEM_NUM; i++) {
+            mpsc_item* item = queue.dequeue();
+            if (item == nullptr || item->value != next[item->producer]++) {
+                return false;
+            }
+        }
+        return true;
+    });
+    std::vector<std::future<void>> producers;
+    for (uint32_t p = 0; p < PRODUCER_NUM; p++) {
+        producers.emplace_back(std::async(std::launch::async, [&queue, &items, p]() {
+            for (uint32_t i = 0; i < ITEM_NUM; i++) {
+                items[p][i].value = i;
+                items[p][i].producer = p;
+                queue.enqueue(&items[p][i]);
+            }
+        }));
+    }
+    for (auto& producer : producers) {
+        producer.wait();
+    }
+    ASSERT_EQ(consumer.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    EXPECT_TRUE(consumer.get());
+    EXPECT_TRUE(queue.empty());
+}
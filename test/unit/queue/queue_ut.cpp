@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 
 #include <future>
+#include <iterator>
 #include <vector>
 
 #include "queue/faa_bounded_queue.h"
@@ -506,3 +507,54 @@ TYPED_TEST(queue_ut, concurrent_dequeue_stress) {
     EXPECT_FALSE(has_error.load());
     EXPECT_TRUE(queue.empty());
 }
+
+// ========== lock_queue Bulk Dequeue Tests ==========
+TEST(lock_queue_ut, dequeue_bulk) {
+    lock_queue<uint32_t> queue;
+    for (uint32_t i = 0; i < 10; i++) {
+        queue.enqueue(i);
+    }
+
+    std::vector<uint32_t> out;
+    EXPECT_EQ(queue.dequeue_bulk(std::back_inserter(out), 4), 4);
+    EXPECT_EQ(queue.dequeue_bulk(std::back_inserter(out), 100), 6);
+    ASSERT_EQ(out.size(), 10);
+    for (uint32_t i = 0; i < 10; i++) {
+        EXPECT_EQ(out[i], i);
+    }
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(lock_queue_ut, dequeue_bulk_after_close) {
+    lock_queue<uint32_t> queue;
+    queue.enqueue(1);
+    queue.enqueue(2);
+    queue.close();
+
+    std::vector<uint32_t> out;
+    EXPECT_EQ(queue.dequeue_bulk(std::back_inserter(out), 8), 2);
+    EXPECT_EQ(queue.dequeue_bulk(std::back_inserter(out), 8), 0);
+    EXPECT_EQ(out.size(), 2);
+}
+
+TEST(lock_queue_ut, dequeue_bulk_wakes_on_enqueue) {
+    lock_queue<uint32_t> queue;
+    std::future<size_t> consumer = std::async(std::launch::async, [&queue]() {
+        std::vector<uint32_t> out;
+        return queue.dequeue_bulk(std::back_inserter(out), 8);
+    });
+    queue.enqueue(7);
+    EXPECT_EQ(consumer.get(), 1);
+}
+
+TEST(lock_queue_ut, enqueue_bulk) {
+    lock_queue<uint32_t> queue;
+    std::vector<uint32_t> in{1, 2, 3};
+    EXPECT_TRUE(queue.enqueue_bulk(in.begin(), in.end()));
+    EXPECT_EQ(queue.size(), 3);
+    EXPECT_EQ(queue.dequeue().value(), 1);
+
+    queue.close();
+    EXPECT_FALSE(queue.enqueue_bulk(in.begin(), in.end()));
+    EXPECT_EQ(queue.size(), 2);
+}
@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "thread_pool/task_graph.h"
+
+TEST(TaskGraphUt, Empty) {
+    ThreadPool threadPool(ThreadPool::THREAD_NUM_DEFAULT);
+    TaskGraph graph;
+    EXPECT_EQ(graph.Size(), 0);
+    EXPECT_TRUE(graph.Run(threadPool));
+}
+
+TEST(TaskGraphUt, Diamond) {
+    ThreadPool threadPool(ThreadPool::THREAD_NUM_DEFAULT);
+    TaskGraph graph;
+
+    std::mutex mtx;
+    std::vector<char> order;
+    auto record = [&mtx, &order](char name) {
+        return [&mtx, &order, name]() {
+            std::lock_guard<std::mutex> lock(mtx);
+            order.push_back(name);
+        };
+    };
+    TaskGraph::NodeId a = graph.Emplace(record('a'));
+    TaskGraph::NodeId b = graph.Emplace(record('b'));
+    TaskGraph::NodeId c = graph.Emplace(record('c'));
+    TaskGraph::NodeId d = graph.Emplace(record('d'));
+    graph.Precede(a, b);
+    graph.Precede(a, c);
+    graph.Precede(b, d);
+    graph.Precede(c, d);
+
+    EXPECT_TRUE(graph.Run(threadPool));
+    ASSERT_EQ(order.size(), 4);
+    EXPECT_EQ(order.front(), 'a');
+    EXPECT_EQ(order.back(), 'd');
+}
+
+TEST(TaskGraphUt, LongChain) {
+    ThreadPool threadPool(ThreadPool::THREAD_NUM_DEFAULT);
+    TaskGraph graph;
+
+    size_t next = 0;
+    bool ordered = true;
+    TaskGraph::NodeId prev = 0;
+    for (size_t i = 0; i < 10000; i++) {
+        TaskGraph::NodeId id = graph.Emplace([&next, &ordered, i]() { ordered = ordered && next++ == i; });
+        if (i > 0) {
+            graph.Precede(prev, id);
+        }
+        prev = id;
+    }
+
+    EXPECT_TRUE(graph.Run(threadPool));
+    EXPECT_TRUE(ordered);
+    EXPECT_EQ(next, 10000);
+}
+
+TEST(TaskGraphUt, Layers) {
+    ThreadPool threadPool(ThreadPool::THREAD_NUM_DEFAULT);
+    TaskGraph graph;
+
+    constexpr size_t LAYERS = 100;
+    constexpr size_t WIDTH = 100;
+    std::vector<std::atomic<bool>> done(LAYERS * WIDTH);
+    std::atomic<bool> ordered{true};
+    for (size_t layer = 0; layer < LAYERS; layer++) {
+        for (size_t i = 0; i < WIDTH; i++) {
+            size_t left = (layer - 1) * WIDTH + i;
+            size_t right = (layer - 1) * WIDTH + (i + 1) % WIDTH;
+            TaskGraph::NodeId id = graph.Emplace([&done, &ordered, layer, left, right, self = layer * WIDTH + i]() {
+                if (layer > 0 && (!done[left].load() || !done[right].load())) {
+                    ordered = false;
+                }
+                done[self] = true;
+            });
+            if (layer > 0) {
+                graph.Precede(left, id);
+                graph.Precede(right, id);
+            }
+        }
+    }
+
+    EXPECT_TRUE(graph.Run(threadPool));
+    EXPECT_TRUE(ordered.load());
+    for (auto& flag : done) {
+        EXPECT_TRUE(flag.load());
+    }
+}
+
+TEST(TaskGraphUt, RunTwice) {
+    ThreadPool threadPool(ThreadPool::THREAD_NUM_DEFAULT);
+    TaskGraph graph;
+
+    std::atomic<int> count{0};
+    TaskGraph::NodeId root = graph.Emplace([&count]() { count++; });
+    for (int i = 0; i < 100; i++) {
+        graph.Precede(root, graph.Emplace([&count]() { count++; }));
+    }
+
+    EXPECT_TRUE(graph.Run(threadPool));
+    EXPECT_TRUE(graph.Run(threadPool));
+    EXPECT_EQ(count.load(), 2 * 101);
+}
+
+TEST(TaskGraphUt, Cycle) {
+    ThreadPool threadPool(ThreadPool::THREAD_NUM_DEFAULT);
+    TaskGraph graph;
+
+    std::atomic<int> count{0};
+    TaskGraph::NodeId a = graph.Emplace([&count]() { count++; });
+    TaskGraph::NodeId b = graph.Emplace([&count]() { count++; });
+    graph.Precede(a, b);
+    graph.Precede(b, a);
+
+    EXPECT_FALSE(graph.Run(threadPool));
+    EXPECT_EQ(count.load(), 0);
+}
+
+TEST(TaskGraphUt, InvalidPool) {
+    ThreadPool threadPool(0);
+    TaskGraph graph;
+
+    std::atomic<int> count{0};
+    TaskGraph::NodeId a = graph.Emplace([&count]() { count++; });
+    graph.Precede(a, graph.Emplace([&count]() { count++; }));
+    graph.Precede(a, graph.Emplace([&count]() { count++; }));
+
+    EXPECT_TRUE(graph.Run(threadPool));
+    EXPECT_EQ(count.load(), 3);
+}
@@ -98,3 +98,392 @@ TEST(ThreadPoolBindUt, Destroy) {
     EXPECT_EQ(threadPool.Valid(), false);
     EXPECT_EQ(threadPool.GetThreadNum(), 0);
 }
+
+// Idle workers spin for a few microseconds and then park on the eventcount. Each round lets every
+// worker park, then pushes from several threads at once; a lost wakeup leaves a future pending.
+TEST(ThreadPoolBindUt, WakeParkedWorkers) {
+    constexpr int ROUND_NUM = 50;
+    constexpr int PRODUCER_NUM = 4;
+    constexpr int TASK_NUM = 8;
+    ThreadPool threadPool(ThreadPool::THREAD_NUM_DEFAULT);
+
+    for (int round = 0; round < ROUND_NUM; round++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        std::vector<std::vector<std::future<int>>> results(PRODUCER_NUM);
+        std::vector<std::thread> producers;
+        for (int p = 0; p < PRODUCER_NUM; p++) {
+            producers.emplace_back([&threadPool, &results, p]() {
+                for (int i = 0; i < TASK_NUM; i++) {
+                    results[p].push_back(threadPool.Push([](int n) { return n; }, p * TASK_NUM + i));
+                }
+            });
+        }
+        for (auto& producer : producers) {
+            producer.join();
+        }
+        for (int p = 0; p < PRODUCER_NUM; p++) {
+            for (int i = 0; i < TASK_NUM; i++) {
+                ASSERT_EQ(results[p][i].wait_for(std::chrono::seconds(1)), std::future_status::ready)
+                    << "round " << round << ", producer " << p << ", task " << i;
+                EXPECT_EQ(results[p][i].get(), p * TASK_NUM + i);
+            }
+        }
+    }
+}
+
+TEST(ThreadPoolBindUt, ParallelFor) {
+    ThreadPool threadPool(ThreadPool::THREAD_NUM_DEFAULT);
+
+    std::vector<int> values(100000, 0);
+    threadPool.ParallelFor<size_t>(0, values.size(), 1024, [&values](size_t i) { values[i] = static_cast<int>(i) * 2; });
+    for (size_t i = 0; i < values.size(); i++) {
+        EXPECT_EQ(values[i], static_cast<int>(i) * 2);
+    }
+}
+
+TEST(ThreadPoolBindUt, ParallelForSmallRange) {
+    ThreadPool threadPool(ThreadPool::THREAD_NUM_DEFAULT);
+
+    std::atomic<int> count{0};
+    threadPool.ParallelFor(0, 10, 1000, [&count](int) { count++; });
+    EXPECT_EQ(count.load(), 10);
+
+    threadPool.ParallelFor(5, 5, 1, [&count](int) { count++; });
+    EXPECT_EQ(count.load(), 10);
+}
+
+TEST(ThreadPoolBindUt, ParallelForNested) {
+    ThreadPool threadPool(ThreadPool::THREAD_NUM_DEFAULT);
+
+    std::atomic<int> count{0};
+    threadPool.ParallelFor(0, 64, 1, [&threadPool, &count](int) {
+        threadPool.ParallelFor(0, 100, 10, [&count](int) { count++; });
+    });
+    EXPECT_EQ(count.load(), 64 * 100);
+}
+
+TEST(ThreadPoolBindUt, ParallelForInvalidPool) {
+    ThreadPool threadPool(0);
+
+    std::vector<int> values(1000, 0);
+    threadPool.ParallelFor<size_t>(0, values.size(), 16, [&values](size_t i) { values[i] = 1; });
+    for (int value : values) {
+        EXPECT_EQ(value, 1);
+    }
+}
+
+TEST(ThreadPoolBindUt, ParallelReduce) {
+    ThreadPool threadPool(ThreadPool::THREAD_NUM_DEFAULT);
+
+    uint64_t sum = threadPool.ParallelReduce<uint64_t>(
+        0, 1000000, 4096, uint64_t{0}, [](uint64_t i) { return i; }, [](uint64_t a, uint64_t b) { return a + b; });
+    EXPECT_EQ(sum, 1000000ULL * 999999ULL / 2);
+}
+
+TEST(ThreadPoolBindUt, ParallelReduceKeepsOrder) {
+    ThreadPool threadPool(ThreadPool::THREAD_NUM_DEFAULT);
+
+    std::string digits = threadPool.ParallelReduce(
+        0, 1000, 7, std::string(), [](int i) { return std::to_string(i % 10); },
+        [](std::string a, const std::string& b) { return a + b; });
+    std::string expected;
+    for (int i = 0; i < 1000; i++) {
+        expected += std::to_string(i % 10);
+    }
+    EXPECT_EQ(digits, expected);
+}
+
+TEST(ThreadPoolBindUt, PriorityOrder) {
+    ThreadPool threadPool(1);
+
+    std::promise<void> gate;
+    std::promise<void> blocked;
+    std::shared_future<void> opened = gate.get_future().share();
+    threadPool.Post([opened, &blocked]() {
+        blocked.set_value();
+        opened.wait();
+    });
+    blocked.get_future().wait();
+
+    std::mutex mtx;
+    std::vector<ThreadPool::Priority> order;
+    auto record = [&mtx, &order](ThreadPool::Priority priority) {
+        std::lock_guard<std::mutex> lock(mtx);
+        order.push_back(priority);
+    };
+    std::vector<std::future<void>> futures;
+    futures.push_back(threadPool.PushPriority(ThreadPool::Priority::LOW, record, ThreadPool::Priority::LOW));
+    futures.push_back(threadPool.PushPriority(ThreadPool::Priority::NORMAL, record, ThreadPool::Priority::NORMAL));
+    futures.push_back(threadPool.PushPriority(ThreadPool::Priority::HIGH, record, ThreadPool::Priority::HIGH));
+    gate.set_value();
+    for (auto& f : futures) {
+        f.wait();
+    }
+
+    ASSERT_EQ(order.size(), 3);
+    EXPECT_EQ(order[0], ThreadPool::Priority::HIGH);
+    EXPECT_EQ(order[1], ThreadPool::Priority::NORMAL);
+    EXPECT_EQ(order[2], ThreadPool::Priority::LOW);
+}
+
+TEST(ThreadPoolBindUt, PriorityAging) {
+    ThreadPool threadPool(1);
+
+    std::promise<void> gate;
+    std::promise<void> blocked;
+    std::shared_future<void> opened = gate.get_future().share();
+    threadPool.Post([opened, &blocked]() {
+        blocked.set_value();
+        opened.wait();
+    });
+    blocked.get_future().wait();
+
+    size_t sequence = 0;
+    size_t lowPosition = 0;
+    std::future<void> low = threadPool.PushPriority(ThreadPool::Priority::LOW, [&]() { lowPosition = sequence++; });
+    std::vector<std::future<void>> futures;
+    for (size_t i = 0; i < ThreadPool::STARVATION_LIMIT * 4; i++) {
+        futures.push_back(threadPool.PushPriority(ThreadPool::Priority::HIGH, [&sequence]() { sequence++; }));
+    }
+    gate.set_value();
+    low.wait();
+    for (auto& f : futures) {
+        f.wait();
+    }
+
+    EXPECT_EQ(lowPosition, ThreadPool::STARVATION_LIMIT);
+}
+
+TEST(ThreadPoolBindUt, StatsSteals) {
+    ThreadPool threadPool(1);
+    threadPool.EnableStats(true);
+    std::promise<void> started;
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::future<void> blocker = threadPool.Push([&started, released]() {
+        started.set_value();
+        released.wait();
+    });
+    started.get_future().wait();
+
+    // The only worker is blocked, so every chunk handed to the pool is run by this thread in Join.
+    std::atomic<int> sum{0};
+    threadPool.ParallelFor(0, 64, 8, [&sum](int i) { sum += i; });
+    release.set_value();
+    blocker.wait();
+    EXPECT_EQ(sum.load(), 64 * 63 / 2);
+
+    // The blocker is recorded after its future is ready.
+    PoolStats stats = threadPool.GetStats();
+    for (int retry = 0; retry < 1000 && stats.workers[0].tasks != 1; retry++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        stats = threadPool.GetStats();
+    }
+    ASSERT_EQ(stats.workers.size(), 2);
+    EXPECT_EQ(stats.workers[0].tasks, 1);
+    EXPECT_EQ(stats.workers[0].steals, 0);
+    EXPECT_GT(stats.workers[1].steals, 0);
+    EXPECT_EQ(stats.workers[1].steals, stats.workers[1].tasks);
+}
+
+TEST(ThreadPoolBindUt, StatsDisabled) {
+    ThreadPool threadPool(ThreadPool::THREAD_NUM_DEFAULT);
+    threadPool.Push([]() {}).wait();
+
+    PoolStats stats = threadPool.GetStats();
+    EXPECT_EQ(stats.workers.size(), ThreadPool::THREAD_NUM_DEFAULT + 1);
+    EXPECT_EQ(stats.runNs.count, 0);
+    EXPECT_EQ(stats.queueWaitNs.count, 0);
+}
+
+TEST(ThreadPoolBindUt, Stats) {
+    ThreadPool threadPool(ThreadPool::THREAD_NUM_DEFAULT);
+    threadPool.EnableStats(true);
+
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < 100; i++) {
+        futures.push_back(threadPool.Push([]() { std::this_thread::sleep_for(std::chrono::microseconds(10)); }));
+    }
+    for (auto& f : futures) {
+        f.wait();
+    }
+    // The future is ready before the worker records the task, so wait for the counters to settle.
+    PoolStats stats;
+    for (int retry = 0; retry < 1000 && stats.runNs.count != 100; retry++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        stats = threadPool.GetStats();
+    }
+
+    uint64_t tasks = 0;
+    uint64_t busyNs = 0;
+    for (const WorkerStatsSnapshot& worker : stats.workers) {
+        tasks += worker.tasks;
+        busyNs += worker.busyNs;
+    }
+    EXPECT_EQ(tasks, 100);
+    EXPECT_EQ(stats.runNs.count, 100);
+    EXPECT_EQ(stats.queueWaitNs.count, 100);
+    EXPECT_GE(stats.runNs.percentile(50), 10000);
+    EXPECT_GE(busyNs, 100 * 10000);
+    EXPECT_EQ(stats.queueDepth, 0);
+}
+
+TEST(ThreadPoolBindUt, PushAfter) {
+    ThreadPool threadPool(ThreadPool::THREAD_NUM_DEFAULT);
+
+    std::promise<ThreadPool::Clock::time_point> fired;
+    auto start = ThreadPool::Clock::now();
+    ThreadPool::TimerId id =
+        threadPool.PushAfter(std::chrono::milliseconds(20), [&fired]() { fired.set_value(ThreadPool::Clock::now()); });
+    EXPECT_NE(id, TimingWheel::INVALID_TIMER);
+    EXPECT_GE(fired.get_future().get() - start, std::chrono::milliseconds(20));
+    EXPECT_FALSE(threadPool.CancelTimer(id));
+}
+
+TEST(ThreadPoolBindUt, PushAt) {
+    ThreadPool threadPool(ThreadPool::THREAD_NUM_DEFAULT);
+
+    std::promise<ThreadPool::Clock::time_point> fired;
+    auto deadline = ThreadPool::Clock::now() + std::chrono::milliseconds(10);
+    threadPool.PushAt(deadline, [&fired]() { fired.set_value(ThreadPool::Clock::now()); });
+    EXPECT_GE(fired.get_future().get(), deadline);
+}
+
+TEST(ThreadPoolBindUt, PushEvery) {
+    ThreadPool threadPool(ThreadPool::THREAD_NUM_DEFAULT);
+
+    std::atomic<int> count{0};
+    std::promise<void> enough;
+    ThreadPool::TimerId id = threadPool.PushEvery(std::chrono::milliseconds(2), [&count, &enough]() {
+        if (++count == 5) {
+            enough.set_value();
+        }
+    });
+    enough.get_future().wait();
+    EXPECT_TRUE(threadPool.CancelTimer(id));
+}
+
+TEST(ThreadPoolBindUt, CancelTimer) {
+    ThreadPool threadPool(ThreadPool::THREAD_NUM_DEFAULT);
+
+    std::atomic<int> count{0};
+    ThreadPool::TimerId id = threadPool.PushAfter(std::chrono::milliseconds(50), [&count]() { count++; });
+    EXPECT_TRUE(threadPool.CancelTimer(id));
+
+    std::promise<void> later;
+    threadPool.PushAfter(std::chrono::milliseconds(100), [&later]() { later.set_value(); });
+    later.get_future().wait();
+    EXPECT_EQ(count.load(), 0);
+}
+
+TEST(ThreadPoolBindUt, ManyTimers) {
+    ThreadPool threadPool(ThreadPool::THREAD_NUM_DEFAULT);
+
+    constexpr int TIMER_NUM = 10000;
+    JoinCounter counter(TIMER_NUM);
+    for (int i = 0; i < TIMER_NUM; i++) {
+        threadPool.PushAfter(std::chrono::microseconds(i * 7), [&counter]() { counter.Done(); });
+    }
+    counter.Wait();
+}
+
+TEST(ThreadPoolBindUt, TimerInvalidPool) {
+    ThreadPool threadPool(0);
+    EXPECT_EQ(threadPool.PushAfter(std::chrono::milliseconds(1), []() {}), TimingWheel::INVALID_TIMER);
+}
+
+TEST(ThreadPoolBindUt, PushCancellable) {
+    ThreadPool threadPool;
+    CancellationSource source;
+    TaskControl control{source.Token(), std::nullopt};
+    std::future<TaskResult<int>> result = threadPool.PushCancellable(control, [](int a) { return a * 2; }, 21);
+    TaskResult<int> value = result.get();
+    EXPECT_EQ(value.status, TaskStatus::COMPLETED);
+    ASSERT_TRUE(value.value.has_value());
+    EXPECT_EQ(*value.value, 42);
+}
+
+TEST(ThreadPoolBindUt, PushCancellableCancelledInQueue) {
+    ThreadPool threadPool(1);
+
+    std::promise<void> gate;
+    std::promise<void> blocked;
+    std::shared_future<void> opened = gate.get_future().share();
+    threadPool.Post([opened, &blocked]() {
+        blocked.set_value();
+        opened.wait();
+    });
+    blocked.get_future().wait();
+
+    CancellationSource source;
+    bool ran = false;
+    TaskControl control{source.Token(), std::nullopt};
+    std::future<TaskResult<void>> cancelled = threadPool.PushCancellable(control, [&ran]() { ran = true; });
+    std::future<TaskResult<int>> kept = threadPool.PushCancellable({}, []() { return 1; });
+    source.Cancel();
+    gate.set_value();
+
+    EXPECT_EQ(cancelled.get().status, TaskStatus::CANCELLED);
+    EXPECT_EQ(kept.get().status, TaskStatus::COMPLETED);
+    EXPECT_FALSE(ran);
+}
+
+TEST(ThreadPoolBindUt, PushCancellableExpired) {
+    ThreadPool threadPool;
+    bool ran = false;
+    TaskControl control{CancellationToken(), ThreadPool::Clock::now() - std::chrono::milliseconds(1)};
+    TaskResult<int> value = threadPool.PushCancellable(control, [&ran]() {
+        ran = true;
+        return 1;
+    }).get();
+    EXPECT_EQ(value.status, TaskStatus::EXPIRED);
+    EXPECT_FALSE(value.value.has_value());
+    EXPECT_FALSE(ran);
+}
+
+TEST(ThreadPoolBindUt, PushCancellableInvalidPool) {
+    ThreadPool threadPool(0);
+    EXPECT_EQ(threadPool.PushCancellable({}, []() {}).valid(), false);
+}
+
+TEST(ThreadPoolBindUt, ShutdownDrain) {
+    ThreadPool threadPool(2);
+    constexpr int TASK_NUM = 1000;
+    std::atomic<int> done{0};
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < TASK_NUM; i++) {
+        futures.push_back(threadPool.Push([&done]() { done.fetch_add(1); }));
+    }
+    EXPECT_EQ(threadPool.Shutdown(), 0);
+    EXPECT_EQ(done.load(), TASK_NUM);
+    for (auto& f : futures) {
+        EXPECT_EQ(f.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+    }
+    EXPECT_EQ(threadPool.Valid(), false);
+    EXPECT_EQ(threadPool.Push([]() {}).valid(), false);
+}
+
+TEST(ThreadPoolBindUt, ShutdownNow) {
+    ThreadPool threadPool(1);
+
+    std::promise<void> gate;
+    std::promise<void> blocked;
+    std::shared_future<void> opened = gate.get_future().share();
+    threadPool.Post([opened, &blocked]() {
+        blocked.set_value();
+        opened.wait();
+    });
+    blocked.get_future().wait();
+
+    std::atomic<int> done{0};
+    for (int i = 0; i < 10; i++) {
+        threadPool.Post([&done]() { done.fetch_add(1); });
+    }
+    std::future<size_t> dropped = std::async(std::launch::async, [&threadPool]() { return threadPool.ShutdownNow(); });
+    while (threadPool.Valid()) {
+        std::this_thread::yield();
+    }
+    gate.set_value();
+    EXPECT_EQ(dropped.get(), 10);
+    EXPECT_EQ(done.load(), 0);
+}
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+#include "thread_pool/thread_pool_coro.h"
+
+namespace {
+
+CoTask<std::thread::id> ResumeOnPool(ThreadPool& pool) {
+    co_await Schedule(pool);
+    co_return std::this_thread::get_id();
+}
+
+CoTask<int> Square(ThreadPool& pool, int n) {
+    co_await Schedule(pool);
+    co_return n * n;
+}
+
+CoTask<int> SumOfSquares(ThreadPool& pool, int count) {
+    std::vector<CoTask<int>> tasks;
+    for (int i = 0; i < count; i++) {
+        tasks.push_back(Square(pool, i));
+    }
+    std::vector<int> squares = co_await WhenAll(std::move(tasks));
+    int sum = 0;
+    for (int square : squares) {
+        sum += square;
+    }
+    co_return sum;
+}
+
+CoTask<void> Increment(ThreadPool& pool, std::atomic<int>& counter) {
+    co_await Schedule(pool, ThreadPool::Priority::HIGH);
+    counter++;
+}
+
+CoTask<int> Immediate(int n) {
+    co_return n;
+}
+
+}  // namespace
+
+TEST(ThreadPoolCoroUt, ScheduleResumesOnWorker) {
+    ThreadPool threadPool(ThreadPool::THREAD_NUM_DEFAULT);
+
+    std::thread::id worker = SyncWait(ResumeOnPool(threadPool));
+    EXPECT_NE(worker, std::this_thread::get_id());
+}
+
+TEST(ThreadPoolCoroUt, ScheduleOnInvalidPool) {
+    ThreadPool threadPool(0);
+
+    std::thread::id worker = SyncWait(ResumeOnPool(threadPool));
+    EXPECT_EQ(worker, std::this_thread::get_id());
+}
+
+TEST(ThreadPoolCoroUt, AwaitValue) {
+    ThreadPool threadPool(ThreadPool::THREAD_NUM_DEFAULT);
+
+    EXPECT_EQ(SyncWait(Square(threadPool, 7)), 49);
+    EXPECT_EQ(SyncWait(Immediate(42)), 42);
+}
+
+TEST(ThreadPoolCoroUt, WhenAll) {
+    ThreadPool threadPool(2);
+
+    int expected = 0;
+    for (int i = 0; i < 1000; i++) {
+        expected += i * i;
+    }
+    EXPECT_EQ(SyncWait(SumOfSquares(threadPool, 1000)), expected);
+}
+
+TEST(ThreadPoolCoroUt, WhenAllVoid) {
+    ThreadPool threadPool(ThreadPool::THREAD_NUM_DEFAULT);
+
+    std::atomic<int> counter{0};
+    std::vector<CoTask<void>> tasks;
+    for (int i = 0; i < 5000; i++) {
+        tasks.push_back(Increment(threadPool, counter));
+    }
+    SyncWait(WhenAll(std::move(tasks)));
+    EXPECT_EQ(counter.load(), 5000);
+}
+
+TEST(ThreadPoolCoroUt, WhenAllEmpty) {
+    ThreadPool threadPool(ThreadPool::THREAD_NUM_DEFAULT);
+
+    std::vector<int> results = SyncWait(WhenAll(std::vector<CoTask<int>>()));
+    EXPECT_TRUE(results.empty());
+}
@@ -122,3 +122,107 @@ TEST(ThreadPoolUt, Destroy) {
     EXPECT_EQ(threadPool.Valid(), false);
     EXPECT_EQ(threadPool.Size(), 0);
 }
+
+TEST(ThreadPoolUt, Stats) {
+    ThreadPool<UtTestData> threadPool(ThreadPool<UtTestData>::THREAD_NUM_DEFAULT, UtTestFuncHeavy);
+    threadPool.EnableStats(true);
+
+    std::vector<std::future<UtTestData>> handles;
+    for (uint32_t i = 0; i < 100; i++) {
+        handles.emplace_back(threadPool.Submit({i, 0}));
+    }
+    for (auto& handle : handles) {
+        handle.wait();
+    }
+    PoolStats stats;
+    for (int retry = 0; retry < 1000 && stats.runNs.count != 100; retry++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        stats = threadPool.GetStats();
+    }
+
+    uint64_t tasks = 0;
+    for (const WorkerStatsSnapshot& worker : stats.workers) {
+        tasks += worker.tasks;
+    }
+    EXPECT_EQ(stats.workers.size(), ThreadPool<UtTestData>::THREAD_NUM_DEFAULT + 1);
+    EXPECT_EQ(tasks, 100);
+    EXPECT_EQ(stats.runNs.count, 100);
+    EXPECT_EQ(stats.queueWaitNs.count, 100);
+    EXPECT_EQ(stats.queueDepth, 0);
+}
+
+TEST(ThreadPoolUt, SubmitCancellable) {
+    ThreadPool<UtTestData> threadPool(ThreadPool<UtTestData>::THREAD_NUM_DEFAULT, UtTestFunc);
+    CancellationSource source;
+    TaskControl control{source.Token(), std::nullopt};
+    TaskResult<UtTestData> result = threadPool.SubmitCancellable({1, 0}, control).get();
+    EXPECT_EQ(result.status, TaskStatus::COMPLETED);
+    ASSERT_TRUE(result.value.has_value());
+    EXPECT_EQ(result.value->out, 1 * 2);
+}
+
+TEST(ThreadPoolUt, SubmitCancelled) {
+    ThreadPool<UtTestData> threadPool(ThreadPool<UtTestData>::THREAD_NUM_DEFAULT, UtTestFunc);
+    CancellationSource source;
+    source.Cancel();
+    TaskControl control{source.Token(), std::nullopt};
+    TaskResult<UtTestData> result = threadPool.SubmitCancellable({1, 0}, control).get();
+    EXPECT_EQ(result.status, TaskStatus::CANCELLED);
+    ASSERT_TRUE(result.value.has_value());
+    EXPECT_EQ(result.value->out, 0);
+}
+
+TEST(ThreadPoolUt, SubmitExpired) {
+    ThreadPool<UtTestData> threadPool(ThreadPool<UtTestData>::THREAD_NUM_DEFAULT, UtTestFunc);
+    TaskControl control{CancellationToken(), std::chrono::steady_clock::now() - std::chrono::milliseconds(1)};
+    TaskResult<UtTestData> result = threadPool.SubmitCancellable({1, 0}, control).get();
+    EXPECT_EQ(result.status, TaskStatus::EXPIRED);
+    EXPECT_EQ(result.value->out, 0);
+}
+
+TEST(ThreadPoolUt, ShutdownDrain) {
+    ThreadPool<UtTestData> threadPool(ThreadPool<UtTestData>::THREAD_NUM_DEFAULT, UtTestFuncHeavy);
+    std::vector<std::future<UtTestData>> handles;
+    for (uint32_t i = 0; i < 1000; i++) {
+        handles.emplace_back(threadPool.Submit({i, 0}));
+    }
+    EXPECT_EQ(threadPool.Shutdown(), 0);
+    for (uint32_t i = 0; i < 1000; i++) {
+        ASSERT_EQ(handles[i].wait_for(std::chrono::seconds(0)), std::future_status::ready);
+        EXPECT_EQ(handles[i].get().out, i * 2);
+    }
+    EXPECT_EQ(threadPool.Valid(), false);
+    EXPECT_EQ(threadPool.Submit({1, 0}).valid(), false);
+}
+
+TEST(ThreadPoolUt, ShutdownNow) {
+    std::promise<void> gate;
+    std::shared_future<void> opened = gate.get_future().share();
+    std::promise<void> blocked;
+    ThreadPool<UtTestData> threadPool(1, [opened, &blocked](UtTestData& data) {
+        if (data.in == 0) {
+            blocked.set_value();
+            opened.wait();
+        }
+        data.out = data.in * 2;
+    });
+    std::future<UtTestData> first = threadPool.Submit({0, 0});
+    blocked.get_future().wait();
+
+    std::vector<std::future<TaskResult<UtTestData>>> handles;
+    for (uint32_t i = 1; i <= 10; i++) {
+        handles.emplace_back(threadPool.SubmitCancellable({i, 0}, {}));
+    }
+    std::future<size_t> dropped = std::async(std::launch::async, [&threadPool]() { return threadPool.ShutdownNow(); });
+    while (threadPool.Valid()) {
+        std::this_thread::yield();
+    }
+    gate.set_value();
+    EXPECT_EQ(dropped.get(), 10);
+    EXPECT_EQ(first.get().out, 0);
+    for (auto& handle : handles) {
+        TaskResult<UtTestData> result = handle.get();
+        EXPECT_EQ(result.status, TaskStatus::CANCELLED);
+        EXPECT_EQ(result.value->out, 0);
+    }
+}
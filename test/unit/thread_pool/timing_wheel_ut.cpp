@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+
+#include <map>
+#include <vector>
+
+#include "thread_pool/timing_wheel.h"
+
+TEST(TimingWheelUt, FiresAtExactTick) {
+    TimingWheel wheel;
+    std::map<size_t, std::vector<uint64_t>> fired;
+
+    // Covers every level boundary and the overflow list beyond 2^24 ticks.
+    std::vector<uint64_t> expires{1, 2, 63, 64, 65, 100, 4095, 4096, 4097, 262143, 262144, 300000, 20000000};
+    for (size_t i = 0; i < expires.size(); i++) {
+        wheel.Add(expires[i], 0, [&wheel, &fired, i]() { fired[i].push_back(wheel.Now()); });
+    }
+    EXPECT_EQ(wheel.Size(), expires.size());
+
+    wheel.Advance(20000001, [](TimingWheel::Callback callback) { callback(); });
+    EXPECT_TRUE(wheel.Empty());
+    ASSERT_EQ(fired.size(), expires.size());
+    for (size_t i = 0; i < expires.size(); i++) {
+        ASSERT_EQ(fired[i].size(), 1);
+        EXPECT_EQ(fired[i][0], expires[i]);
+    }
+}
+
+TEST(TimingWheelUt, PastExpireFiresNextTick) {
+    TimingWheel wheel(100);
+    int count = 0;
+    wheel.Add(50, 0, [&count]() { count++; });
+
+    wheel.Advance(100, [](TimingWheel::Callback callback) { callback(); });
+    EXPECT_EQ(count, 0);
+    wheel.Advance(101, [](TimingWheel::Callback callback) { callback(); });
+    EXPECT_EQ(count, 1);
+}
+
+TEST(TimingWheelUt, Cancel) {
+    TimingWheel wheel;
+    int count = 0;
+    TimingWheel::TimerId near = wheel.Add(10, 0, [&count]() { count++; });
+    TimingWheel::TimerId far = wheel.Add(10000, 0, [&count]() { count++; });
+    wheel.Add(20, 0, [&count]() { count += 100; });
+
+    EXPECT_TRUE(wheel.Cancel(near));
+    EXPECT_TRUE(wheel.Cancel(far));
+    EXPECT_FALSE(wheel.Cancel(far));
+    EXPECT_FALSE(wheel.Cancel(TimingWheel::INVALID_TIMER));
+
+    wheel.Advance(20000, [](TimingWheel::Callback callback) { callback(); });
+    EXPECT_EQ(count, 100);
+    EXPECT_TRUE(wheel.Empty());
+}
+
+TEST(TimingWheelUt, Periodic) {
+    TimingWheel wheel;
+    std::vector<uint64_t> ticks;
+    uint64_t tick = 0;
+    TimingWheel::TimerId id = wheel.Add(5, 70, [&ticks, &tick]() { ticks.push_back(tick); });
+
+    for (tick = 1; tick <= 300; tick++) {
+        wheel.Advance(tick, [](TimingWheel::Callback callback) { callback(); });
+    }
+    EXPECT_EQ(ticks, (std::vector<uint64_t>{5, 75, 145, 215, 285}));
+    EXPECT_EQ(wheel.Size(), 1);
+
+    EXPECT_TRUE(wheel.Cancel(id));
+    EXPECT_TRUE(wheel.Empty());
+}
+
+TEST(TimingWheelUt, NextTick) {
+    TimingWheel wheel;
+    EXPECT_EQ(wheel.NextTick(), 64);
+
+    wheel.Add(3, 0, []() {});
+    EXPECT_EQ(wheel.NextTick(), 3);
+}